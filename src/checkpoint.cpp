@@ -0,0 +1,454 @@
+#include "checkpoint.h"
+#include "operator.h"
+#include "eval.h"
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char CHECKPOINT_MAGIC[8] = {'H', 'M', 'A', 'C', 'K', 'P', 'T', '4'};
+
+template <typename T>
+static void put(std::string &b, const T &value)
+{
+    b.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+static void put(std::string &b, const std::vector<T> &v)
+{
+    put(b, int(v.size()));
+    b.append(reinterpret_cast<const char *>(v.data()), sizeof(T) * v.size());
+}
+
+static void put(std::string &b, const std::string &s)
+{
+    put(b, int(s.size()));
+    b.append(s);
+}
+
+static void put(std::string &b, const Solution &s)
+{
+    int len = s.len();
+    put(b, len);
+    for (int i = 0; i < len; i++)
+    {
+        const Route &r = s.peek(i);
+        put(b, r.node_list);
+        put(b, r.customer_list);
+        put(b, r.status_list);
+        put(b, r.dep_time);
+        put(b, r.ret_time);
+        put(b, r.transcost);
+        put(b, r.total_cost);
+        put(b, r.x);
+        put(b, r.y);
+        put(b, r.node_num);
+        put(b, r.customer_num);
+        put(b, r.cluster);
+    }
+    put(b, s.cost);
+}
+
+static void put(std::string &b, const RouteProximity &p)
+{
+    for (int i = 0; i < PROXIMITY_MEMORY; i++)
+    {
+        put(b, p.space_gap[i]);
+        put(b, p.time_gap[i]);
+    }
+    put(b, p.gaps);
+    put(b, p.max_space);
+    put(b, p.max_time);
+    put(b, p.calls);
+    put(b, p.filtering);
+}
+
+/* puts every field passed to it, see PhaseStats::fields */
+struct Writer
+{
+    std::string &b;
+
+    template <typename T>
+    void operator()(const T &value)
+    {
+        put(this->b, value);
+    }
+};
+
+static void put(std::string &b, PhaseStats &phases)
+{
+    Writer writer = {b};
+    phases.fields(writer);
+}
+
+/* reads back what put wrote */
+class Reader
+{
+public:
+    Reader(const std::string &b) : b(b) {}
+
+    template <typename T>
+    void get(T &value)
+    {
+        this->need(sizeof(T));
+        memcpy(&value, this->b.data() + this->pos, sizeof(T));
+        this->pos += sizeof(T);
+    }
+
+    template <typename T>
+    void get(std::vector<T> &v)
+    {
+        int n;
+        this->get(n);
+        this->need(sizeof(T) * size_t(std::max(n, 0)));
+        v.resize(n);
+        memcpy(v.data(), this->b.data() + this->pos, sizeof(T) * n);
+        this->pos += sizeof(T) * n;
+    }
+
+    void get(std::string &s)
+    {
+        int n;
+        this->get(n);
+        this->need(size_t(std::max(n, 0)));
+        s.assign(this->b, this->pos, n);
+        this->pos += n;
+    }
+
+    void get(Solution &s, const Data &data)
+    {
+        int len;
+        this->get(len);
+        s.clear(data);
+        for (int i = 0; i < len; i++)
+        {
+            Route r(data);
+            this->get(r.node_list);
+            this->get(r.customer_list);
+            this->get(r.status_list);
+            r.update(data);
+            // keep the values of the search, they may differ from recomputed ones in the last digits
+            this->get(r.dep_time);
+            this->get(r.ret_time);
+            this->get(r.transcost);
+            this->get(r.total_cost);
+            this->get(r.x);
+            this->get(r.y);
+            this->get(r.node_num);
+            this->get(r.customer_num);
+            this->get(r.cluster);
+            s.append(r);
+        }
+        this->get(s.cost);
+    }
+
+    void get(RouteProximity &p)
+    {
+        for (int i = 0; i < PROXIMITY_MEMORY; i++)
+        {
+            this->get(p.space_gap[i]);
+            this->get(p.time_gap[i]);
+        }
+        this->get(p.gaps);
+        this->get(p.max_space);
+        this->get(p.max_time);
+        this->get(p.calls);
+        this->get(p.filtering);
+    }
+
+    void get(PhaseStats &phases)
+    {
+        phases.fields(*this);
+    }
+
+    // gets every field passed to it, see PhaseStats::fields
+    template <typename T>
+    void operator()(T &value)
+    {
+        this->get(value);
+    }
+
+private:
+    const std::string &b;
+    size_t pos = 0;
+
+    void need(size_t n)
+    {
+        if (this->pos + n > this->b.size())
+        {
+            printf("Broken checkpoint\n");
+            exit(-1);
+        }
+    }
+};
+
+Checkpointer::Checkpointer(const Data &data)
+{
+    this->file = data.checkpoint;
+    this->tmp_file = data.checkpoint + ".tmp";
+    this->interval = data.checkpoint_interval;
+    this->last_write = wall_clock();
+}
+
+void Checkpointer::snapshot(SearchState &state, const Data &data, SearchContext &ctx)
+{
+    std::string &b = this->buffer;
+    b.clear();
+    b.append(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    put(b, data.problem_name);
+    put(b, data.node_num);
+    put(b, data.seed);
+
+    put(b, state.run);
+    put(b, state.gen);
+    put(b, state.no_improve);
+    put(b, state.cost_in_this_run);
+    put(b, state.used_sec);
+    put(b, state.individual);
+    put(b, state.individual_fit);
+
+    std::ostringstream rng;
+    rng << ctx.rng;
+    put(b, rng.str());
+    put(b, ctx.escape_local_optima);
+    put(b, ctx.destroy_ratio_l);
+    put(b, ctx.destroy_ratio_u);
+    // set by the initialization a resumed run skips
+    put(b, std::get<0>(ctx.lambda_gamma));
+    put(b, std::get<1>(ctx.lambda_gamma));
+    put(b, ctx.n_insert);
+    put(b, ctx.ksize);
+    put(b, ctx.proximity);
+    put(b, ctx.best_s);
+    put(b, ctx.find_best_time);
+    put(b, ctx.find_best_run);
+    put(b, ctx.find_best_gen);
+    put(b, ctx.find_bks_time);
+    put(b, ctx.find_bks_run);
+    put(b, ctx.find_bks_gen);
+    put(b, ctx.find_better);
+    put(b, ctx.call_count_move_eval);
+    put(b, ctx.mean_duration_move_eval);
+    put(b, ctx.run_costs);
+    put(b, ctx.run_times);
+    put(b, ctx.phases);
+
+    if (wall_clock() - this->last_write >= clock_t(this->interval) * CLOCKS_PER_SEC)
+    {
+        if (!this->write()) perror("Failed to write checkpoint");
+        this->last_write = wall_clock();
+    }
+}
+
+bool Checkpointer::write()
+{
+    if (this->buffer.empty()) return true;
+    const std::string &b = this->buffer;
+    int fd = open(this->tmp_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) return false;
+    size_t done = 0;
+    while (done < b.size())
+    {
+        ssize_t n = ::write(fd, b.data() + done, b.size() - done);
+        if (n <= 0)
+        {
+            close(fd);
+            return false;
+        }
+        done += size_t(n);
+    }
+    bool ok = (fsync(fd) == 0);
+    ok = (close(fd) == 0) && ok;
+    return ok && rename(this->tmp_file.c_str(), this->file.c_str()) == 0;
+}
+
+static std::string read_file(const std::string &file)
+{
+    std::ifstream in(file.c_str(), std::ios::binary);
+    if (!in)
+    {
+        printf("Cannot open %s\n", file.c_str());
+        exit(-1);
+    }
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+static bool is_checkpoint(const std::string &b)
+{
+    return b.size() >= sizeof(CHECKPOINT_MAGIC) && memcmp(b.data(), CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) == 0;
+}
+
+/* a resumed search must be the one checkpointed, a warm start only needs the same nodes */
+static void read_checkpoint(const std::string &b, const Data &data, SearchState &state, SearchContext &ctx, bool resume)
+{
+    Reader r(b);
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    r.get(magic);
+    std::string problem_name;
+    int node_num, seed;
+    r.get(problem_name);
+    r.get(node_num);
+    r.get(seed);
+    if (node_num != data.node_num || (resume && (problem_name != data.problem_name || seed != data.seed)))
+    {
+        printf("Checkpoint of %s (seed %d) does not fit %s (seed %d)\n", problem_name.c_str(), seed, data.problem_name.c_str(), data.seed);
+        exit(-1);
+    }
+
+    r.get(state.run);
+    r.get(state.gen);
+    r.get(state.no_improve);
+    r.get(state.cost_in_this_run);
+    r.get(state.used_sec);
+    r.get(state.individual, data);
+    r.get(state.individual_fit);
+
+    std::string rng;
+    r.get(rng);
+    std::istringstream(rng) >> ctx.rng;
+    r.get(ctx.escape_local_optima);
+    r.get(ctx.destroy_ratio_l);
+    r.get(ctx.destroy_ratio_u);
+    r.get(std::get<0>(ctx.lambda_gamma));
+    r.get(std::get<1>(ctx.lambda_gamma));
+    r.get(ctx.n_insert);
+    r.get(ctx.ksize);
+    r.get(ctx.proximity);
+    r.get(ctx.best_s, data);
+    r.get(ctx.find_best_time);
+    r.get(ctx.find_best_run);
+    r.get(ctx.find_best_gen);
+    r.get(ctx.find_bks_time);
+    r.get(ctx.find_bks_run);
+    r.get(ctx.find_bks_gen);
+    r.get(ctx.find_better);
+    r.get(ctx.call_count_move_eval);
+    r.get(ctx.mean_duration_move_eval);
+    r.get(ctx.run_costs);
+    r.get(ctx.run_times);
+    r.get(ctx.phases);
+}
+
+void load_checkpoint(const std::string &file, const Data &data, SearchState &state, SearchContext &ctx)
+{
+    std::string b = read_file(file);
+    if (!is_checkpoint(b))
+    {
+        printf("%s is not a checkpoint\n", file.c_str());
+        exit(-1);
+    }
+    read_checkpoint(b, data, state, ctx, true);
+    printf("Resume from checkpoint %s: run %d, gen %d, best cost %.4f\n", file.c_str(), state.run, state.gen, ctx.best_s.cost);
+}
+
+/* node lists of the best solution in a solution file written by output_best_solution. Stations on
+a hyperarc are printed without their (arr_RD, dep_RD), they are not part of the node list */
+static std::vector<std::vector<int>> parse_solution_file(const std::string &file, const std::string &b, const Data &data)
+{
+    std::vector<std::vector<int>> best, routes;
+    double best_cost = INFINITY;
+    std::istringstream in(b);
+    std::string line;
+    while (getline(in, line))
+    {
+        if (line.compare(0, 6, "route ") == 0)
+        {
+            size_t pos = line.find("nodes:");
+            if (pos == std::string::npos) continue;
+            std::vector<int> nl;
+            const char *p = line.c_str() + pos + 6;
+            char *end;
+            while (true)
+            {
+                long node = strtol(p, &end, 10);
+                if (end == p) break;
+                p = end;
+                if (node < 0 || node >= data.node_num)
+                {
+                    printf("Node %ld in %s is not in %s\n", node, file.c_str(), data.problem_name.c_str());
+                    exit(-1);
+                }
+                bool status = (*p == '(');
+                if (status) p = strchr(p, ')') + 1;
+                if (status || data.node[node].type == 1) nl.push_back(int(node));
+            }
+            routes.push_back(nl);
+        }
+        else if (line.compare(0, 11, "Total cost:") == 0)
+        {
+            // the file keeps the solutions of all earlier calls, take the best one
+            double cost = stod(line.substr(11));
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best = routes;
+            }
+            routes.clear();
+        }
+    }
+    if (best.empty())
+    {
+        printf("No solution found in %s\n", file.c_str());
+        exit(-1);
+    }
+    return best;
+}
+
+void load_initial_solution(const std::string &file, const Data &data, Solution &s, SearchContext &ctx)
+{
+    std::string b = read_file(file);
+    std::vector<std::vector<int>> routes;
+    if (is_checkpoint(b))
+    {
+        SearchContext tmp(data);
+        SearchState state;
+        read_checkpoint(b, data, state, tmp, false);
+        for (int i = 0; i < tmp.best_s.len(); i++) routes.push_back(tmp.best_s.peek(i).node_list);
+    }
+    else
+        routes = parse_solution_file(file, b, data);
+
+    // keep the routes still feasible for this instance, their customers only once
+    s.clear(data);
+    std::vector<char> routed(data.node_num, 0);
+    int dropped = 0;
+    for (auto &nl : routes)
+    {
+        std::vector<int> kept;
+        int customers = 0;
+        for (int node : nl)
+        {
+            if (data.node[node].type != 1 || !routed[node]) kept.push_back(node);
+            if (data.node[node].type == 1 && !routed[node]) customers++;
+            if (data.node[node].type == 1) routed[node] = 1;
+        }
+        // a route left with stations only would cost a vehicle for nothing
+        if (customers == 0) continue;
+        Route r(data);
+        int flag = 0, index_negtive_first = -1;
+        double cost = 0.0;
+        update_route_status(kept, r.status_list, data, flag, cost, index_negtive_first);
+        if (flag != 1)
+        {
+            for (int node : kept) if (data.node[node].type == 1) routed[node] = 0;
+            dropped++;
+            continue;
+        }
+        r.node_list = kept;
+        r.update(data);
+        s.append(r);
+        s.cost += cost;
+    }
+    int missing = 0;
+    for (int i = 0; i < data.node_num; i++)
+        if (data.node[i].type == 1 && !routed[i]) missing++;
+    printf("Initial solution %s: %d routes, cost %.2f, %d infeasible routes dropped, %d customers to insert\n",
+           file.c_str(), s.len(), s.cost, dropped, missing);
+
+    // customers new to the instance, or of dropped routes, get new routes
+    ctx.n_insert = RCRS;
+    ctx.ksize = data.k_init;
+    ctx.lambda_gamma = std::make_tuple(0.5, 0.5);
+    new_route_insertion(s, data, ctx);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <ctime>
+#include "data.h"
+#include "solution.h"
+#include "context.h"
+
+/* state of a level-1 search at the end of a gen, besides what its SearchContext holds */
+struct SearchState
+{
+    int run = 0;
+    int gen = 0;
+    int no_improve = 0;
+    double cost_in_this_run = 0.0;
+    double used_sec = 0.0;
+    Solution individual;
+    double individual_fit = 0.0;
+};
+
+/* binary checkpoint of a level-1 search (--checkpoint). A snapshot is taken in memory at the end
+of every gen and written to disk every data.checkpoint_interval seconds, atomically through a
+temporary file. A search stopped by a signal writes the latest snapshot as well */
+class Checkpointer
+{
+public:
+    Checkpointer(const Data &data);
+
+    void snapshot(SearchState &state, const Data &data, SearchContext &ctx);
+
+    // write the latest snapshot
+    bool write();
+
+private:
+    std::string file;
+    std::string tmp_file;
+    std::string buffer; // the latest snapshot, empty if none
+    clock_t last_write;
+    int interval;
+};
+
+// restore a search from a checkpoint written by Checkpointer, exits if it does not belong to data
+void load_checkpoint(const std::string &file, const Data &data, SearchState &state, SearchContext &ctx);
+
+// warm start: read s from a solution file written by output_best_solution or from the best solution
+// of a checkpoint; infeasible routes are dropped and unrouted customers inserted into new routes
+void load_initial_solution(const std::string &file, const Data &data, Solution &s, SearchContext &ctx);
@@ -37,8 +37,20 @@ const bool DEFAULT_2_OPT = false;
 const bool DEFAULT_OR_OPT = false;
 const bool DEFAULT_2_EX = false;
 const int DEFAULT_OR_OPT_LEN = 3;
+const bool DEFAULT_ROUTE_PROXIMITY = false; // skip route pairs far apart in the inter-route opts
+const int PROXIMITY_WARMUP = 20; // find_local_optima calls scanning all route pairs before pairs are skipped
+const int PROXIMITY_EXPLORE = 10; // afterwards every PROXIMITY_EXPLORE-th call still scans all route pairs
+const int PROXIMITY_MEMORY = 256; // gaps of the latest route pairs holding an improving move that are kept
+const double PROXIMITY_QUANTILE = 0.95; // share of those gaps within the learned radius
+const double PROXIMITY_SLACK = 1.25; // route pairs are skipped beyond this multiple of the learned radius
+const bool DEFAULT_DIRTY_ROUTES = false; // CDNS re-stations and re-scans only the routes changed since it last ran
+const int DEFAULT_GRANULAR = 0; // k nearest customers kept as granular neighbours, 0 means all inter-route moves are evaluated
 const int DEFAUTL_EX_LEN = 2;
 const bool DEFAULT_SKIP_FINDING_LO = false; // if skip find_local_optima
+// small step-size opts, registered in scan_route_pairs in operator.cpp
+enum SmallOpt {TWO_OPT, TWO_OPT_STAR, OR_OPT_SINGLE, OR_OPT_DOUBLE, TWO_EXCHANGE, SMALL_OPT_NUM};
+// whether a sub-neighborhood of the opt is a route pair (r1, r2), otherwise a single route
+const bool SMALL_OPT_ROUTE_PAIRS[SMALL_OPT_NUM] = {false, true, false, true, true};
 
 /* large neighborhood opts */
 const int DEFAULT_ELO = 1; // 0 means not using large neighborhood, -1 means not using local search
@@ -49,6 +61,10 @@ const bool DEFAULT_RT_REMOVAL = false;
 const bool DEFAULT_GD_INSERTION = false;
 const bool DEFAULT_RG_INSERTION = false;
 const bool DEFAULT_RD_R_I = false;
+const int DEFAULT_LNS_SAMPLES = 1; // destroy-repair samples per (destroy, repair) pair in each LNS iteration
+// destroy and repair opts, registered in the tables at the top of operator.cpp
+enum DestroyOpt {RANDOM_REMOVAL, RELATED_REMOVAL, DESTROY_OPT_NUM};
+enum RepairOpt {REGRET_INSERTION, GREEDY_INSERTION, REPAIR_OPT_NUM};
 
 /* insertion type-1: insertion without considering existing routes,
 each time building a new route with an arbitrary selected customer.
@@ -81,6 +97,7 @@ const std::string DEFAULT_REPLACEMENT = ONE_ON_ONE;
 
 /* removal and insertion */
 const double DEFAULT_ALPHA = 1.0;   // relatedness para
+const int RELATED_NEIGHBOURS = 64; // most related customers ranked per customer, related removal scans the others when all of them are removed
 const double PENALTY_FACTOR = 10.0; // penalty factor for tw constraint
 
 // The flags for a sequence status
@@ -89,10 +106,30 @@ const int INFEASIBLE = -1;
 // If decomposition, # of subproblem(s)
 const int DEFAULT_SUBPROBLEM = 1; 
 
+/* Parallelism */
+const int DEFAULT_THREADS = 1; // number of worker threads, 1 means sequential search
+const bool DEFAULT_STEADY_STATE = false; // asynchronous steady-state memetic search instead of generations
+const bool DEFAULT_PARALLEL_RUNS = false; // start all runs at once, they share one Data
+const int DEFAULT_ISLANDS = 1; // number of islands searching concurrently, 1 means no island model
+const int DEFAULT_MIGRATION = 5; // islands send their best solution to the next island every DEFAULT_MIGRATION gens
+
+/* Memory */
+const size_t POOL_MAX_BYTES = 32 << 20; // bytes of free buffers each thread keeps for reuse
+
 /* Hybrid Search Framework*/
 const bool DEFAULT_INDIVIDUAL_SEARCH = false;
 const bool DEFAULT_POPULATION_SEARCH = false;
 
+/* Checkpoint */
+const int DEFAULT_CHECKPOINT_INTERVAL = 600; // seconds between two checkpoints written to disk
+
+/* Phases of HMA, their time is scheduled with --phase_time or --adaptive_phases */
+enum Phase {CONSTRUCTION, CDNS, LNS, DECOMPOSITION, PHASE_NUM};
+const std::string PHASE_NAMES[PHASE_NUM] = {"construction", "cdns", "lns", "decomposition"};
+const bool DEFAULT_ADAPTIVE_PHASES = false;
+const int PHASE_EXPLORE_GENS = 10; // adaptive phases: a phase not run for this many gens is run again
+const double PHASE_DECAY = 0.5; // adaptive phases: weight of the past in the improvement per second
+
 /* Parallel Station Insertion*/
 const bool DEFAULT_PARALLEL_STATION_INSERTION = false;
 
@@ -0,0 +1,460 @@
+#pragma once
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <random>
+#include <ctime>
+#include <csignal>
+#include <mutex>
+#include "config.h"
+#include "data.h"
+#include "move.h"
+#include "solution.h"
+
+/* individual of the genetic algorithm in parallel station insertion (PSI) */
+struct Candidate
+{
+    int x[100];
+    std::vector<int> node_list;
+    double fitx;
+};
+
+// number of the signal interrupting the search, 0 if none (see signalHandler)
+extern volatile sig_atomic_t interrupted;
+
+/* wall-clock deadline of a search (see wall_clock), cheap enough to be checked in inner loops.
+An interrupted search is past all its deadlines */
+class Deadline
+{
+public:
+    Deadline() {}
+    // tmax seconds after start, NO_LIMIT means no deadline
+    Deadline(clock_t start, int tmax)
+    {
+        if (tmax == NO_LIMIT) return;
+        this->limited = true;
+        this->at = start + clock_t(tmax) * CLOCKS_PER_SEC;
+    }
+
+    // keep the earlier of both deadlines
+    void limit(const Deadline &other)
+    {
+        if (!other.limited) return;
+        if (!this->limited || other.at < this->at) this->at = other.at;
+        this->limited = true;
+    }
+
+    bool expired()
+    {
+        if (interrupted) this->passed = true;
+        if (!this->limited || this->passed) return this->passed;
+        this->passed = (wall_clock() >= this->at);
+        return this->passed;
+    }
+
+private:
+    bool limited = false;
+    bool passed = false;
+    clock_t at = 0;
+};
+
+/* time and improvement of the phases of HMA in one run, and which phase to run next
+when the phases are scheduled (--phase_time, --adaptive_phases) */
+class PhaseStats
+{
+public:
+    void reset()
+    {
+        *this = PhaseStats();
+    }
+
+    // the phase ran from start until now and improved the best cost by improvement
+    void add(int phase, clock_t start, double improvement)
+    {
+        double sec = (wall_clock() - start) / (CLOCKS_PER_SEC*1.0);
+        this->seconds[phase] += sec;
+        this->improvement[phase] += improvement;
+        this->recent_seconds[phase] = PHASE_DECAY * this->recent_seconds[phase] + sec;
+        this->recent_improvement[phase] = PHASE_DECAY * this->recent_improvement[phase] + improvement;
+        this->calls[phase]++;
+    }
+
+    static bool enabled(int phase, const Data &data)
+    {
+        if (!data.phase_time.empty() && data.phase_time[phase] <= 0) return false;
+        if (phase == DECOMPOSITION) return data.population_search;
+        if (phase == LNS) return data.individual_search || !data.population_search;
+        return phase == CDNS;
+    }
+
+    // with --adaptive_phases the phase with the best recent improvement per second, every phase
+    // is run at least once every PHASE_EXPLORE_GENS gens. Otherwise the phase furthest behind its share
+    int next(const Data &data, int gen)
+    {
+        int best = -1;
+        double best_value = -double(INFINITY);
+        double total = this->seconds[CDNS] + this->seconds[LNS] + this->seconds[DECOMPOSITION];
+        for (int phase = CDNS; phase < PHASE_NUM; phase++)
+        {
+            if (!enabled(phase, data)) continue;
+            double value;
+            if (data.adaptive_phases)
+            {
+                if (this->calls[phase] == 0 || gen - this->last_gen[phase] >= PHASE_EXPLORE_GENS)
+                {
+                    best = phase;
+                    break;
+                }
+                value = this->recent_improvement[phase] / std::max(this->recent_seconds[phase], 1e-6);
+            }
+            else value = data.phase_time[phase] * total - this->seconds[phase];
+            if (value > best_value)
+            {
+                best = phase;
+                best_value = value;
+            }
+        }
+        if (best == -1) best = CDNS;
+        this->last_gen[best] = gen;
+        return best;
+    }
+
+    void output() const
+    {
+        double total = 0.0;
+        for (int phase = 0; phase < PHASE_NUM; phase++) total += this->seconds[phase];
+        for (int phase = 0; phase < PHASE_NUM; phase++)
+        {
+            if (this->calls[phase] == 0) continue;
+            printf("Phase %s: %d times, %.2lf sec (%.1lf%%), improvement %.2lf, %.2lf per sec\n", PHASE_NAMES[phase].c_str(), this->calls[phase],
+                   this->seconds[phase], 100.0 * this->seconds[phase] / std::max(total, 1e-6),
+                   this->improvement[phase], this->improvement[phase] / std::max(this->seconds[phase], 1e-6));
+        }
+    }
+
+    // pass every field to io, in a fixed order (checkpoints)
+    template <typename IO>
+    void fields(IO &io)
+    {
+        for (int phase = 0; phase < PHASE_NUM; phase++)
+        {
+            io(this->seconds[phase]);
+            io(this->improvement[phase]);
+            io(this->recent_seconds[phase]);
+            io(this->recent_improvement[phase]);
+            io(this->calls[phase]);
+            io(this->last_gen[phase]);
+        }
+    }
+
+private:
+    double seconds[PHASE_NUM] = {};
+    double improvement[PHASE_NUM] = {};
+    double recent_seconds[PHASE_NUM] = {};
+    double recent_improvement[PHASE_NUM] = {};
+    int calls[PHASE_NUM] = {};
+    int last_gen[PHASE_NUM] = {};
+};
+
+/* which route pairs the inter-route opts scan (--route_proximity). The gaps, in space and in time
+windows, of route pairs holding an improving move are sampled in the calls scanning all pairs. Other
+calls skip the pairs further apart than PROXIMITY_SLACK times the PROXIMITY_QUANTILE of the samples */
+struct RouteProximity
+{
+    double space_gap[PROXIMITY_MEMORY] = {}; // the latest sampled gaps
+    double time_gap[PROXIMITY_MEMORY] = {};
+    long gaps = 0; // gaps sampled so far
+    double max_space = 0.0; // radius of the current call
+    double max_time = 0.0;
+    long calls = 0; // find_local_optima calls so far
+    bool filtering = false; // whether the current call skips route pairs
+
+    // add what other learned since it was a copy of start: its calls and its newest samples
+    void merge(const RouteProximity &start, const RouteProximity &other)
+    {
+        this->calls += other.calls - start.calls;
+        for (long g = std::max(start.gaps, other.gaps - long(PROXIMITY_MEMORY)); g < other.gaps; g++)
+        {
+            int slot = int(this->gaps % PROXIMITY_MEMORY);
+            this->space_gap[slot] = other.space_gap[g % PROXIMITY_MEMORY];
+            this->time_gap[slot] = other.time_gap[g % PROXIMITY_MEMORY];
+            this->gaps++;
+        }
+    }
+};
+
+class SharedBest;
+class IslandRing;
+class Checkpointer;
+struct SearchState;
+
+/* scratch state of one thread of a search: what building and evaluating solutions changes besides the
+solutions. The thread running a search uses its SearchContext, the other workers of a parallel region
+building or evaluating solutions each get a Workspace of their own, those running CDNS a helper
+SearchContext (see SearchContext::workers) */
+class Workspace
+{
+public:
+    std::mt19937 rng; // random number generator
+    unsigned int deferred_seed = 0; // see defer_seed
+    bool seed_deferred = false;
+    int threads; // threads this search may use, nested parallel regions split it among their workers
+    Deadline deadline; // of the current run, the search stops early once it has expired
+
+    // type-1 insertion
+    std::tuple<double, double> lambda_gamma = std::make_tuple(0.5,0.5); // params of RCRS method
+    std::string n_insert = ""; //indicate which type-1 insertion should be used, RCRS or TD
+    int ksize = 0;
+
+    Move tmp_move; // for preventing memory allocation
+    std::vector<double> rd, rp, load, cd, cp; // buffers of cal_tc
+
+    // PSI
+    std::vector<Candidate> individual;
+    Candidate best_r;
+    int popsize = 0;
+    double delta = 0.0;
+
+    Workspace(const Data &data)
+    {
+        this->rng.seed(data.seed);
+        this->threads = data.threads;
+
+        this->rd.resize(MAX_NODE_IN_ROUTE);
+        this->rp.resize(MAX_NODE_IN_ROUTE);
+        this->load.resize(MAX_NODE_IN_ROUTE);
+        this->cd.resize(MAX_NODE_IN_ROUTE);
+        this->cp.resize(MAX_NODE_IN_ROUTE);
+
+        this->individual.resize(301);
+    }
+
+    // workspaces of the other n - 1 workers of a parallel region started by this thread,
+    // each may use threads threads. They take over the deadline and insertion parameters
+    std::vector<Workspace> fork(int n, int threads, const Data &data) const
+    {
+        std::vector<Workspace> workers(std::max(n - 1, 0), Workspace(data));
+        for (auto &worker : workers)
+        {
+            worker.threads = threads;
+            worker.deadline = this->deadline;
+            worker.lambda_gamma = this->lambda_gamma;
+            worker.n_insert = this->n_insert;
+            worker.ksize = this->ksize;
+        }
+        return workers;
+    }
+
+    // rng is reseeded with seed right before it is next drawn from (see reseed), such that work that
+    // rarely draws does not pay for seeding
+    void defer_seed(unsigned int seed)
+    {
+        this->deferred_seed = seed;
+        this->seed_deferred = true;
+    }
+
+    void reseed()
+    {
+        if (!this->seed_deferred) return;
+        this->rng.seed(this->deferred_seed);
+        this->seed_deferred = false;
+    }
+};
+
+/* all mutable state of one search. Data is read-only once loaded,
+so it can be shared by several searches */
+class SearchContext : public Workspace
+{
+public:
+    unsigned int seed; // rng is reseeded with seed + run after every run
+    int first_run = 1; // runs [first_run, last_run] are done by this search
+    int last_run;
+    PhaseStats phases; // of the current run
+
+    // concurrent searches (parallel runs, islands), see SharedBest and IslandRing
+    SharedBest *shared = nullptr;
+    IslandRing *ring = nullptr;
+    int island = 0;
+
+    // checkpoint and resume of a level-1 search, see checkpoint.h
+    Checkpointer *checkpointer = nullptr;
+    SearchState *resume = nullptr; // continue this state in the next run
+
+    // parameters temporarily altered by the search, initialized from Data
+    int escape_local_optima;
+    double destroy_ratio_l;
+    double destroy_ratio_u;
+
+    // local search
+    std::vector<Move> mem[SMALL_OPT_NUM]; // best move in each sub-neighborhood, per opt
+    // with --dirty_routes, the routes of each memo slot found to hold no improving move, 0 if none.
+    // ALS and CLS share mem but keep their own keys, see swap_mem_key
+    std::vector<unsigned long long> mem_key[SMALL_OPT_NUM];
+    std::vector<unsigned long long> cls_mem_key[SMALL_OPT_NUM];
+    int max_num; // max route number, used to index mem
+    std::vector<Solution> s_vector; // lns_samples solutions per (destroy, repair) pair in LNS
+    RouteProximity proximity;
+    // contexts of the other workers of parallel regions running CDNS (see workers), built on first use
+    // and kept for the rest of the search, such that their memo is only allocated once
+    std::vector<std::unique_ptr<SearchContext>> helpers;
+
+    // best solution and when it was found
+    Solution best_s;
+    clock_t find_best_time = 0;
+    int find_best_run = 0;
+    int find_best_gen = 0;
+    clock_t find_bks_time = 0;
+    int find_bks_run = 0;
+    int find_bks_gen = 0;
+    bool find_better = false;
+    long call_count_move_eval = 0;
+    double mean_duration_move_eval = 0.0;
+    std::vector<double> run_costs; // best cost and consumed time of every run
+    std::vector<double> run_times;
+
+    SearchContext(const Data &data) : Workspace(data)
+    {
+        this->seed = data.seed;
+        this->last_run = data.runs;
+        this->escape_local_optima = data.escape_local_optima;
+        this->destroy_ratio_l = data.destroy_ratio_l;
+        this->destroy_ratio_u = data.destroy_ratio_u;
+
+        this->max_num = data.vehicle.max_num;
+        for (auto opt : data.small_opts)
+        {
+            if (SMALL_OPT_ROUTE_PAIRS[opt])
+                this->mem[opt] = std::vector<Move>(this->max_num * this->max_num);
+            else
+                this->mem[opt] = std::vector<Move>(this->max_num);
+            if (data.dirty_routes)
+            {
+                this->mem_key[opt].assign(this->mem[opt].size(), 0);
+                this->cls_mem_key[opt].assign(this->mem[opt].size(), 0);
+            }
+        }
+
+        int tmp_solution_num = int(data.destroy_opts.size()) * int(data.repair_opts.size());
+        if (data.rd_removal_insertion)
+            tmp_solution_num = 1;
+        this->s_vector.resize(tmp_solution_num * data.lns_samples);
+
+        this->best_s.cost = double(INFINITY);
+    }
+
+    void clear_mem()
+    {
+        for (auto &x : this->mem)
+        {
+            for (auto &move : x)
+            {
+                move.len_1 = 0;
+            }
+        }
+        for (auto &x : this->mem_key)
+        {
+            std::fill(x.begin(), x.end(), 0);
+        }
+        for (auto &x : this->cls_mem_key)
+        {
+            std::fill(x.begin(), x.end(), 0);
+        }
+    }
+
+    // exchange the memo keys of ALS and CLS, such that each finds the keys its previous call left
+    void swap_mem_key()
+    {
+        for (int opt = 0; opt < SMALL_OPT_NUM; opt++)
+        {
+            this->mem_key[opt].swap(this->cls_mem_key[opt]);
+        }
+    }
+
+    /* the contexts of the n workers of a parallel region running CDNS: worker 0 searches with this
+    context, the others with helpers, which take over the threads, deadline and parameters this context
+    has now. Call it before the region, helpers are built here */
+    std::vector<SearchContext *> workers(int n, const Data &data)
+    {
+        std::vector<SearchContext *> workers(1, this);
+        if (int(this->helpers.size()) < n - 1) this->helpers.resize(n - 1);
+        for (int w = 1; w < n; w++)
+        {
+            std::unique_ptr<SearchContext> &helper = this->helpers[w - 1];
+            if (!helper) helper.reset(new SearchContext(data));
+            helper->threads = this->threads;
+            helper->deadline = this->deadline;
+            helper->lambda_gamma = this->lambda_gamma;
+            helper->n_insert = this->n_insert;
+            helper->ksize = this->ksize;
+            helper->escape_local_optima = this->escape_local_optima;
+            helper->destroy_ratio_l = this->destroy_ratio_l;
+            helper->destroy_ratio_u = this->destroy_ratio_u;
+            helper->proximity = this->proximity;
+            workers.push_back(helper.get());
+        }
+        return workers;
+    }
+
+    Move &get_mem(SmallOpt opt, int r1, int r2)
+    {
+        if (SMALL_OPT_ROUTE_PAIRS[opt])
+            return this->mem[opt][r1 * this->max_num + r2];
+        return this->mem[opt][r1];
+    }
+
+    unsigned long long &get_mem_key(SmallOpt opt, int r1, int r2)
+    {
+        if (SMALL_OPT_ROUTE_PAIRS[opt])
+            return this->mem_key[opt][r1 * this->max_num + r2];
+        return this->mem_key[opt][r1];
+    }
+};
+
+/* searches running concurrently on one Data (--parallel_runs, --islands) report
+their best solution to the main search context */
+class SharedBest
+{
+public:
+    SearchContext &main;
+    std::mutex mutex; // guards main
+
+    SharedBest(SearchContext &main) : main(main) {}
+};
+
+/* islands searching concurrently on a ring (--islands). Every island sends its best
+solution to the next island through a mailbox holding at most one solution */
+class IslandRing
+{
+public:
+    IslandRing(int islands) : mailbox(islands), full(islands, 0), mailbox_mutex(islands) {}
+
+    // a waiting migrant is only overwritten by a better one
+    void send(int island, const Solution &s)
+    {
+        int to = (island + 1) % int(this->mailbox.size());
+        std::lock_guard<std::mutex> lock(this->mailbox_mutex[to]);
+        if (!this->full[to] || s.cost - this->mailbox[to].cost < -PRECISION)
+        {
+            this->mailbox[to] = s;
+            this->full[to] = 1;
+        }
+    }
+
+    bool receive(int island, Solution &s)
+    {
+        std::lock_guard<std::mutex> lock(this->mailbox_mutex[island]);
+        if (!this->full[island]) return false;
+        s = this->mailbox[island];
+        this->full[island] = 0;
+        return true;
+    }
+
+private:
+    std::vector<Solution> mailbox;
+    std::vector<char> full; // not vector<bool>, its bits share words across mailboxes
+    std::vector<std::mutex> mailbox_mutex;
+};
@@ -13,14 +13,11 @@ Data::Data(const Data& data, std::vector<int> &subproblem) // main problem to su
     this->node_num = this->customer_num + this->station_num + 1;
     std::vector<double> tmp_v_1(this->node_num, 0.0);
     std::vector<bool> tmp_v_2(this->node_num, 0.0);
-    std::vector<int> tmp_v_3(this->node_num, 0);
     for (int i = 0; i < this->node_num; i++)
     {
                 this->node.push_back({0, 0, 0.0, 0.0, 0.0, 0.0, 0.0});
                 this->dist.push_back(tmp_v_1);
                 this->time.push_back(tmp_v_1);
-                this->rm.push_back(tmp_v_1);
-                this->rm_argrank.push_back(tmp_v_3);
                 this->pm.push_back(tmp_v_2);
     }
     this->vehicle.max_num = data.vehicle.max_num;
@@ -104,155 +101,25 @@ Data::Data(const Data& data, std::vector<int> &subproblem) // main problem to su
     this->all_delivery = all_delivery;
     this->all_pickup = all_pickup;
 
-    std::vector<std::vector<int>> tmp_v_4(this->customer_num+this->station_num+1, std::vector<int>(this->station_num, 0));
-    for (int i = 0; i <= this->customer_num + this->station_num; i++)
-    {       
-        this->optimal_staion.push_back(tmp_v_4);
-    }
-    std::vector<double> c_f_c_dist(this->station_num);
-    std::vector<int> c_f_c_dist_argrank(this->station_num); 
-    for (int i = 0; i <= this->customer_num; i++)    // c-f-c
-    {       
-        for (int j=0; j<= this->customer_num;j++){
-              if (i!=j) {
-                for (int k=this->customer_num+1;k<=this->customer_num+this->station_num;k++){
-                        c_f_c_dist[k-this->customer_num-1]=this->dist[i][k]+this->dist[k][j];
-                }
-
-                argsort(c_f_c_dist, c_f_c_dist_argrank, this->station_num);
-                if (i != this->DC && j!= this->DC){
-                    for (int k=0;k<this->station_num;k++){
-                    optimal_staion[i][j][k]=c_f_c_dist_argrank[k]+this->customer_num+1;
-                    }                    
-                }
-                else if (i == this->DC) {
-                    if (this->dist[i][c_f_c_dist_argrank[0]+this->customer_num+1]!=0){
-                        for (int k=0;k<this->station_num;k++){
-                        optimal_staion[i][j][k]=c_f_c_dist_argrank[k]+this->customer_num+1;
-                        }                         
-                    }
-                    else {
-                    for (int k=0;k<this->station_num-1;k++){
-                        optimal_staion[i][j][k]=c_f_c_dist_argrank[k+1]+this->customer_num+1;
-                    } 
-                    optimal_staion[i][j][this->station_num-1]=c_f_c_dist_argrank[0]+this->customer_num+1;
-                    }
-                }  
-                else if (j == this->DC) {
-                    if (this->dist[c_f_c_dist_argrank[0]+this->customer_num+1][j]!=0){
-                        for (int k=0;k<this->station_num;k++){
-                        optimal_staion[i][j][k]=c_f_c_dist_argrank[k]+this->customer_num+1;
-                        }                         
-                    }
-                    else {
-                    for (int k=0;k<this->station_num-1;k++){
-                        optimal_staion[i][j][k]=c_f_c_dist_argrank[k+1]+this->customer_num+1;
-                    } 
-                    optimal_staion[i][j][this->station_num-1]=c_f_c_dist_argrank[0]+this->customer_num+1;
-                    }
-                } 
-              }  
-        }
-    }    
-
-    for (int i = 0; i <= this->customer_num; i++)    // c-f-f
-    {       
-        for (int j=this->customer_num+1; j<= this->customer_num+this->station_num;j++){
-                for (int k=this->customer_num+1;k<=this->customer_num+this->station_num;k++){
-                        if (k!=j) {
-                        c_f_c_dist[k-this->customer_num-1]=this->dist[i][k]+this->dist[k][j];
-                        }
-                        else{
-                        c_f_c_dist[k-this->customer_num-1]=double(INFINITY);    
-                        }
-                }
-
-                argsort(c_f_c_dist, c_f_c_dist_argrank, this->station_num);
-                if (i != this->DC){
-                    for (int k=0;k<this->station_num;k++){
-                    optimal_staion[i][j][k]=c_f_c_dist_argrank[k]+this->customer_num+1;
-                    }                    
-                }
-                else {
-                    if (this->dist[i][c_f_c_dist_argrank[0]+this->customer_num+1]!=0){
-                        for (int k=0;k<this->station_num;k++){
-                        optimal_staion[i][j][k]=c_f_c_dist_argrank[k]+this->customer_num+1;
-                        }                         
-                    }
-                    else {
-                    for (int k=0;k<this->station_num-1;k++){
-                        optimal_staion[i][j][k]=c_f_c_dist_argrank[k+1]+this->customer_num+1;
-                    } 
-                    optimal_staion[i][j][this->station_num-1]=c_f_c_dist_argrank[0]+this->customer_num+1;
-                    }
-                }  
-        }
-    }    
-
-    for (int i = this->customer_num+1; i <= this->customer_num+this->station_num; i++)    // f-f-c
-    {       
-        for (int j=0; j<= this->customer_num; j++){
-                for (int k=this->customer_num+1;k<=this->customer_num+this->station_num;k++){
-                        if (k!=i) {
-                        c_f_c_dist[k-this->customer_num-1]=this->dist[i][k]+this->dist[k][j];
-                        }
-                        else{
-                        c_f_c_dist[k-this->customer_num-1]=double(INFINITY);    
-                        }
-                }
-
-                argsort(c_f_c_dist, c_f_c_dist_argrank, this->station_num);
-                if (j != this->DC){
-                    for (int k=0;k<this->station_num;k++){
-                    optimal_staion[i][j][k]=c_f_c_dist_argrank[k]+this->customer_num+1;
-                    }                    
-                }
-                else {
-                    if (this->dist[c_f_c_dist_argrank[0]+this->customer_num+1][j]!=0){
-                        for (int k=0;k<this->station_num;k++){
-                        optimal_staion[i][j][k]=c_f_c_dist_argrank[k]+this->customer_num+1;
-                        }                         
-                    }
-                    else {
-                    for (int k=0;k<this->station_num-1;k++){
-                        optimal_staion[i][j][k]=c_f_c_dist_argrank[k+1]+this->customer_num+1;
-                    } 
-                    optimal_staion[i][j][this->station_num-1]=c_f_c_dist_argrank[0]+this->customer_num+1;
-                    }
-                }                      
-        }
-    } 
-
-    for (int i = this->customer_num+1; i <= this->customer_num+this->station_num; i++)    // f-f-f
-    {       
-        for (int j = this->customer_num+1; j <= this->customer_num+this->station_num; j++){
-              if (i!=j) {
-                for (int k=this->customer_num+1;k<=this->customer_num+this->station_num;k++){
-                        if (i!=k && j!=k){
-                        c_f_c_dist[k-this->customer_num-1]=this->dist[i][k]+this->dist[k][j];    
-                        }
-                        else{
-                        c_f_c_dist[k-this->customer_num-1]=double(INFINITY); 
-                        }
-                        
-                }
-
-                argsort(c_f_c_dist, c_f_c_dist_argrank, this->station_num);
-                for (int k=0;k<this->station_num;k++){
-                    optimal_staion[i][j][k]=c_f_c_dist_argrank[k]+this->customer_num+1;
-                }                    
-      
-              }  
-        }
-    }       
     this->individual_search = data.individual_search;
     this->population_search = data.population_search;
+    this->phase_time = data.phase_time;
+    this->adaptive_phases = data.adaptive_phases;
     this->parallel_insertion = data.parallel_insertion;
     this->conservative_local_search = data.conservative_local_search;
     this->aggressive_local_search = data.aggressive_local_search;
     this->subproblem_range = data.subproblem_range;
+    this->threads = data.threads;
+    this->steady_state = data.steady_state;
+    this->parallel_runs = data.parallel_runs;
+    this->islands = data.islands;
+    this->migration = data.migration;
+    this->checkpoint = data.checkpoint;
+    this->checkpoint_interval = data.checkpoint_interval;
+    this->resume = data.resume;
+    // initial_solution is not copied, node IDs of a subproblem differ from those of the instance
     this->seed = data.seed;
-    this->rng.seed(this->seed);
+    std::mt19937 rng(this->seed); // only used to shuffle latin, the search owns its rng
     // set parameters
     this->pruning = data.pruning;
     this->if_output = data.if_output;
@@ -277,7 +144,7 @@ Data::Data(const Data& data, std::vector<int> &subproblem) // main problem to su
                 this->latin.push_back(std::make_tuple(lambda, gamma));
             }
         }
-        std::shuffle(this->latin.begin(), this->latin.end(), this->rng);
+        std::shuffle(this->latin.begin(), this->latin.end(), rng);
     }
 
     this->init = PERTURB;  //data.init; 
@@ -299,37 +166,27 @@ Data::Data(const Data& data, std::vector<int> &subproblem) // main problem to su
     if (data.two_opt)
     {
         this->two_opt = true;
-        small_opts.push_back("2opt");
-        std::vector<Move> tmp_mem(this->vehicle.max_num);
-        mem.insert(std::pair<std::string, std::vector<Move>>("2opt", tmp_mem));
+        small_opts.push_back(TWO_OPT);
     }
     if (data.two_opt_star)
     {
         this->two_opt_star = true;
-        small_opts.push_back("2opt*");
-        std::vector<Move> tmp_mem(this->vehicle.max_num * this->vehicle.max_num);
-        mem.insert(std::pair<std::string, std::vector<Move>>("2opt*", tmp_mem));
+        small_opts.push_back(TWO_OPT_STAR);
     }
 
     if (data.or_opt)
     {
         this->or_opt = true;
         this->or_opt_len = data.or_opt_len;
-        small_opts.push_back("oropt_single");
-        small_opts.push_back("oropt_double");
-        std::vector<Move> tmp_mem_0(this->vehicle.max_num);
-        std::vector<Move> tmp_mem_1(this->vehicle.max_num * this->vehicle.max_num);
-        mem.insert(std::pair<std::string, std::vector<Move>>("oropt_single", tmp_mem_0));
-        mem.insert(std::pair<std::string, std::vector<Move>>("oropt_double", tmp_mem_1));
+        small_opts.push_back(OR_OPT_SINGLE);
+        small_opts.push_back(OR_OPT_DOUBLE);
     }
 
     if (data.two_exchange)
     {
         this->two_exchange = true;
         this->exchange_len = data.exchange_len;
-        small_opts.push_back("2exchange");
-        std::vector<Move> tmp_mem(this->vehicle.max_num * this->vehicle.max_num);
-        mem.insert(std::pair<std::string, std::vector<Move>>("2exchange", tmp_mem));
+        small_opts.push_back(TWO_EXCHANGE);
     }
 
     this->escape_local_optima = data.escape_local_optima;
@@ -337,7 +194,7 @@ Data::Data(const Data& data, std::vector<int> &subproblem) // main problem to su
     if (data.random_removal)
     {
         this->random_removal = true;
-        destroy_opts.push_back("random_removal");
+        destroy_opts.push_back(RANDOM_REMOVAL);
     }
 
     if (data.related_removal)
@@ -345,7 +202,7 @@ Data::Data(const Data& data, std::vector<int> &subproblem) // main problem to su
         this->related_removal = true;
         this->alpha = data.alpha;
         this->r = this->alpha * (this->all_dist / this->all_time);
-        destroy_opts.push_back("related_removal");
+        destroy_opts.push_back(RELATED_REMOVAL);
     }
 
 
@@ -355,19 +212,23 @@ Data::Data(const Data& data, std::vector<int> &subproblem) // main problem to su
     if (data.regret_insertion)
     {
         this->regret_insertion = true;
-        repair_opts.push_back("regret_insertion");
+        repair_opts.push_back(REGRET_INSERTION);
     }
 
     if (data.greedy_insertion)
     {
         this->greedy_insertion = true;
-        repair_opts.push_back("greedy_insertion");
+        repair_opts.push_back(GREEDY_INSERTION);
     }
 
     if (data.rd_removal_insertion)
     {
         this->rd_removal_insertion = true;
     }
+    this->lns_samples = data.lns_samples;
+    this->granular = data.granular;
+    this->route_proximity = data.route_proximity;
+    this->dirty_routes = data.dirty_routes;
 
     this->bks = data.bks;
 
@@ -419,14 +280,11 @@ Data::Data(ArgumentParser &parser)
             this->node_num = stoi(results[1]);
             std::vector<double> tmp_v_1(this->node_num, 0.0);
             std::vector<bool> tmp_v_2(this->node_num, 0.0);
-            std::vector<int> tmp_v_3(this->node_num, 0);
             for (int i = 0; i < this->node_num; i++)
             {
                 this->node.push_back({0, 0, 0.0, 0.0, 0.0, 0.0, 0.0});
                 this->dist.push_back(tmp_v_1);
                 this->time.push_back(tmp_v_1);
-                this->rm.push_back(tmp_v_1);
-                this->rm_argrank.push_back(tmp_v_3);
                 this->pm.push_back(tmp_v_2);
             }
         }
@@ -618,156 +476,6 @@ Data::Data(ArgumentParser &parser)
     this->all_delivery = all_delivery;
     this->all_pickup = all_pickup;
 
-
-    /*
-   
-    we preprocess the charging stations to rank them for insertion between each pair of nodes. 
-    The ranking metric is the extra cost induced by insertion.
-    To balance efficiency and solution quality, only the top sr·|F| ranked charging stations are considered for insertion in both PSI and SSI
-    
-    */
-
-    std::vector<std::vector<int>> tmp_v_4(this->customer_num+this->station_num+1, std::vector<int>(this->station_num, 0));
-    for (int i = 0; i <= this->customer_num + this->station_num; i++)
-    {       
-        this->optimal_staion.push_back(tmp_v_4);
-    }
-    std::vector<double> c_f_c_dist(this->station_num);
-    std::vector<int> c_f_c_dist_argrank(this->station_num); 
-    for (int i = 0; i <= this->customer_num; i++)    // c-f-c
-    {       
-        for (int j=0; j<= this->customer_num;j++){
-              if (i!=j) {
-                for (int k=this->customer_num+1;k<=this->customer_num+this->station_num;k++){
-                        c_f_c_dist[k-this->customer_num-1]=this->dist[i][k]+this->dist[k][j];
-                }
-
-                argsort(c_f_c_dist, c_f_c_dist_argrank, this->station_num);
-                if (i != this->DC && j!= this->DC){
-                    for (int k=0;k<this->station_num;k++){
-                    optimal_staion[i][j][k]=c_f_c_dist_argrank[k]+this->customer_num+1;
-                    }                    
-                }
-                else if (i == this->DC) {
-                    if (this->dist[i][c_f_c_dist_argrank[0]+this->customer_num+1]!=0){
-                        for (int k=0;k<this->station_num;k++){
-                        optimal_staion[i][j][k]=c_f_c_dist_argrank[k]+this->customer_num+1;
-                        }                         
-                    }
-                    else {
-                    for (int k=0;k<this->station_num-1;k++){
-                        optimal_staion[i][j][k]=c_f_c_dist_argrank[k+1]+this->customer_num+1;
-                    } 
-                    optimal_staion[i][j][this->station_num-1]=c_f_c_dist_argrank[0]+this->customer_num+1;
-                    }
-                }  
-                else if (j == this->DC) {
-                    if (this->dist[c_f_c_dist_argrank[0]+this->customer_num+1][j]!=0){
-                        for (int k=0;k<this->station_num;k++){
-                        optimal_staion[i][j][k]=c_f_c_dist_argrank[k]+this->customer_num+1;
-                        }                         
-                    }
-                    else {
-                    for (int k=0;k<this->station_num-1;k++){
-                        optimal_staion[i][j][k]=c_f_c_dist_argrank[k+1]+this->customer_num+1;
-                    } 
-                    optimal_staion[i][j][this->station_num-1]=c_f_c_dist_argrank[0]+this->customer_num+1;
-                    }
-                } 
-              }  
-        }
-    }    
-
-    for (int i = 0; i <= this->customer_num; i++)    // c-f-f
-    {       
-        for (int j=this->customer_num+1; j<= this->customer_num+this->station_num;j++){
-                for (int k=this->customer_num+1;k<=this->customer_num+this->station_num;k++){
-                        if (k!=j) {
-                        c_f_c_dist[k-this->customer_num-1]=this->dist[i][k]+this->dist[k][j];
-                        }
-                        else{
-                        c_f_c_dist[k-this->customer_num-1]=double(INFINITY);    
-                        }
-                }
-
-                argsort(c_f_c_dist, c_f_c_dist_argrank, this->station_num);
-                if (i != this->DC){
-                    for (int k=0;k<this->station_num;k++){
-                    optimal_staion[i][j][k]=c_f_c_dist_argrank[k]+this->customer_num+1;
-                    }                    
-                }
-                else {
-                    if (this->dist[i][c_f_c_dist_argrank[0]+this->customer_num+1]!=0){
-                        for (int k=0;k<this->station_num;k++){
-                        optimal_staion[i][j][k]=c_f_c_dist_argrank[k]+this->customer_num+1;
-                        }                         
-                    }
-                    else {
-                    for (int k=0;k<this->station_num-1;k++){
-                        optimal_staion[i][j][k]=c_f_c_dist_argrank[k+1]+this->customer_num+1;
-                    } 
-                    optimal_staion[i][j][this->station_num-1]=c_f_c_dist_argrank[0]+this->customer_num+1;
-                    }
-                }  
-        }
-    }    
-
-    for (int i = this->customer_num+1; i <= this->customer_num+this->station_num; i++)    // f-f-c
-    {       
-        for (int j=0; j<= this->customer_num; j++){
-                for (int k=this->customer_num+1;k<=this->customer_num+this->station_num;k++){
-                        if (k!=i) {
-                        c_f_c_dist[k-this->customer_num-1]=this->dist[i][k]+this->dist[k][j];
-                        }
-                        else{
-                        c_f_c_dist[k-this->customer_num-1]=double(INFINITY);    
-                        }
-                }
-
-                argsort(c_f_c_dist, c_f_c_dist_argrank, this->station_num);
-                if (j != this->DC){
-                    for (int k=0;k<this->station_num;k++){
-                    optimal_staion[i][j][k]=c_f_c_dist_argrank[k]+this->customer_num+1;
-                    }                    
-                }
-                else {
-                    if (this->dist[c_f_c_dist_argrank[0]+this->customer_num+1][j]!=0){
-                        for (int k=0;k<this->station_num;k++){
-                        optimal_staion[i][j][k]=c_f_c_dist_argrank[k]+this->customer_num+1;
-                        }                         
-                    }
-                    else {
-                    for (int k=0;k<this->station_num-1;k++){
-                        optimal_staion[i][j][k]=c_f_c_dist_argrank[k+1]+this->customer_num+1;
-                    } 
-                    optimal_staion[i][j][this->station_num-1]=c_f_c_dist_argrank[0]+this->customer_num+1;
-                    }
-                }                      
-        }
-    } 
-
-    for (int i = this->customer_num+1; i <= this->customer_num+this->station_num; i++)    // f-f-f
-    {       
-        for (int j = this->customer_num+1; j <= this->customer_num+this->station_num; j++){
-              if (i!=j) {
-                for (int k=this->customer_num+1;k<=this->customer_num+this->station_num;k++){
-                        if (i!=k && j!=k){
-                        c_f_c_dist[k-this->customer_num-1]=this->dist[i][k]+this->dist[k][j];    
-                        }
-                        else{
-                        c_f_c_dist[k-this->customer_num-1]=double(INFINITY); 
-                        }
-                        
-                }
-                argsort(c_f_c_dist, c_f_c_dist_argrank, this->station_num);
-                for (int k=0;k<this->station_num;k++){
-                    optimal_staion[i][j][k]=c_f_c_dist_argrank[k]+this->customer_num+1;
-                }                    
-      
-              }  
-        }
-    }       
-    
     // print summary information
     printf("Node number: %d\n", this->node_num);
     printf("Customer number: %d\n", this->customer_num);
@@ -780,7 +488,7 @@ Data::Data(ArgumentParser &parser)
     std::cout << '\n';
     if (parser.exists("random_seed"))
         this->seed = std::stoi(parser.retrieve<std::string>("random_seed"));
-    this->rng.seed(this->seed);
+    std::mt19937 rng(this->seed); // only used to shuffle latin, the search owns its rng
     printf("Initial random seed: %d\n", this->seed);
 
     // set parameters
@@ -833,7 +541,7 @@ Data::Data(ArgumentParser &parser)
                 this->latin.push_back(std::make_tuple(lambda, gamma));
             }
         }
-        std::shuffle(this->latin.begin(), this->latin.end(), this->rng);
+        std::shuffle(this->latin.begin(), this->latin.end(), rng);
     }
 
     if (parser.exists("init"))
@@ -891,9 +599,7 @@ Data::Data(ArgumentParser &parser)
     {
         printf("2-opt: on\n");
         this->two_opt = true;
-        small_opts.push_back("2opt");
-        std::vector<Move> tmp_mem(this->vehicle.max_num);
-        mem.insert(std::pair<std::string, std::vector<Move>>("2opt", tmp_mem));
+        small_opts.push_back(TWO_OPT);
     }
     else
         printf("2-opt: off\n");
@@ -902,9 +608,7 @@ Data::Data(ArgumentParser &parser)
     {
         printf("2-opt*: on\n");
         this->two_opt_star = true;
-        small_opts.push_back("2opt*");
-        std::vector<Move> tmp_mem(this->vehicle.max_num * this->vehicle.max_num);
-        mem.insert(std::pair<std::string, std::vector<Move>>("2opt*", tmp_mem));
+        small_opts.push_back(TWO_OPT_STAR);
     }
     else
         printf("2-opt*: off\n");
@@ -914,12 +618,8 @@ Data::Data(ArgumentParser &parser)
         printf("or-opt: on\n");
         this->or_opt = true;
         this->or_opt_len = std::stoi(parser.retrieve<std::string>("or_opt"));
-        small_opts.push_back("oropt_single");
-        small_opts.push_back("oropt_double");
-        std::vector<Move> tmp_mem_0(this->vehicle.max_num);
-        std::vector<Move> tmp_mem_1(this->vehicle.max_num * this->vehicle.max_num);
-        mem.insert(std::pair<std::string, std::vector<Move>>("oropt_single", tmp_mem_0));
-        mem.insert(std::pair<std::string, std::vector<Move>>("oropt_double", tmp_mem_1));
+        small_opts.push_back(OR_OPT_SINGLE);
+        small_opts.push_back(OR_OPT_DOUBLE);
     }
     else
         printf("or-opt: off\n");
@@ -929,9 +629,7 @@ Data::Data(ArgumentParser &parser)
         printf("2-exchange: on\n");
         this->two_exchange = true;
         this->exchange_len = std::stoi(parser.retrieve<std::string>("two_exchange"));
-        small_opts.push_back("2exchange");
-        std::vector<Move> tmp_mem(this->vehicle.max_num * this->vehicle.max_num);
-        mem.insert(std::pair<std::string, std::vector<Move>>("2exchange", tmp_mem));
+        small_opts.push_back(TWO_EXCHANGE);
     }
     else
         printf("2-exchange: off\n");
@@ -944,7 +642,7 @@ Data::Data(ArgumentParser &parser)
     {
         printf("random_removal: on\n");
         this->random_removal = true;
-        destroy_opts.push_back("random_removal");
+        destroy_opts.push_back(RANDOM_REMOVAL);
     }
     else
         printf("random_removal: off\n");
@@ -956,7 +654,7 @@ Data::Data(ArgumentParser &parser)
         if (parser.exists("alpha"))
             this->alpha = std::stod(parser.retrieve<std::string>("alpha"));
         this->r = this->alpha * (this->all_dist / this->all_time);
-        destroy_opts.push_back("related_removal");
+        destroy_opts.push_back(RELATED_REMOVAL);
         printf("alpha: %f, relateness norm factor: %f\n", this->alpha, this->r);
     }
     else
@@ -977,7 +675,7 @@ Data::Data(ArgumentParser &parser)
     {
         printf("regret_insertion: on\n");
         this->regret_insertion = true;
-        repair_opts.push_back("regret_insertion");
+        repair_opts.push_back(REGRET_INSERTION);
     }
     else
         printf("regret_insertion: off\n");
@@ -986,7 +684,7 @@ Data::Data(ArgumentParser &parser)
     {
         printf("greedy_insertion: on\n");
         this->greedy_insertion = true;
-        repair_opts.push_back("greedy_insertion");
+        repair_opts.push_back(GREEDY_INSERTION);
     }
     else
         printf("greedy_insertion: off\n");
@@ -999,6 +697,40 @@ Data::Data(ArgumentParser &parser)
     else
         printf("Random removal and insertion: off\n");
 
+    if (parser.exists("lns_samples"))
+    {
+        this->lns_samples = std::stoi(parser.retrieve<std::string>("lns_samples"));
+        if (this->lns_samples < 1)
+        {
+            printf("LNS samples should be at least 1\n");
+            exit(-1);
+        }
+    }
+    printf("LNS samples: %d\n", this->lns_samples);
+
+    if (parser.exists("route_proximity"))
+    {
+        this->route_proximity = true;
+        printf("Route proximity filter: on\n");
+    }
+
+    if (parser.exists("dirty_routes"))
+    {
+        this->dirty_routes = true;
+        printf("Dirty route tracking: on\n");
+    }
+
+    if (parser.exists("granular"))
+    {
+        this->granular = std::stoi(parser.retrieve<std::string>("granular"));
+        if (this->granular < 0)
+        {
+            printf("Granular neighbourhood size should be at least 0\n");
+            exit(-1);
+        }
+        printf("Granular neighbourhoods: k = %d\n", this->granular);
+    }
+
     if (parser.exists("bks"))
         this->bks = std::stod(parser.retrieve<std::string>("bks"));
     
@@ -1008,6 +740,53 @@ Data::Data(ArgumentParser &parser)
     if (parser.exists("population_search"))
         this->population_search = true; 
 
+    if (parser.exists("phase_time"))
+    {
+        // e.g. cdns=0.2,lns=0.4,decomposition=0.4, phases not given get no time
+        this->phase_time.assign(PHASE_NUM, 0.0);
+        double total = 0.0;
+        for (auto &item : split(parser.retrieve<std::string>("phase_time"), ','))
+        {
+            std::vector<std::string> r = split(item, '=');
+            int phase = PHASE_NUM;
+            if (r.size() == 2) phase = int(std::find(PHASE_NAMES, PHASE_NAMES + PHASE_NUM, r[0]) - PHASE_NAMES);
+            if (phase == CONSTRUCTION || phase == PHASE_NUM || std::stod(r[1]) < 0)
+            {
+                printf("Unknown phase time: %s, expect cdns/lns/decomposition=SHARE\n", item.c_str());
+                exit(-1);
+            }
+            this->phase_time[phase] = std::stod(r[1]);
+            total += this->phase_time[phase];
+        }
+        if (total <= 0)
+        {
+            printf("Phase time should not be all zero\n");
+            exit(-1);
+        }
+        for (auto &share : this->phase_time) share /= total;
+        printf("Phase time:");
+        for (int phase = CDNS; phase < PHASE_NUM; phase++) printf(" %s %.2f", PHASE_NAMES[phase].c_str(), this->phase_time[phase]);
+        printf("\n");
+    }
+
+    if (parser.exists("adaptive_phases"))
+        this->adaptive_phases = true;
+
+    if (parser.exists("checkpoint"))
+        this->checkpoint = parser.retrieve<std::string>("checkpoint");
+    if (parser.exists("checkpoint_interval")){
+        this->checkpoint_interval = std::stoi(parser.retrieve<std::string>("checkpoint_interval"));
+        if (this->checkpoint_interval < 0)
+        {
+            printf("Checkpoint interval should be at least 0\n");
+            exit(-1);
+        }
+    }
+    if (parser.exists("resume"))
+        this->resume = parser.retrieve<std::string>("resume");
+    if (parser.exists("initial_solution"))
+        this->initial_solution = parser.retrieve<std::string>("initial_solution");
+
     if (parser.exists("parallel_insertion"))
         this->parallel_insertion = true;    
 
@@ -1029,6 +808,48 @@ Data::Data(ArgumentParser &parser)
     }
     printf("Subproblem num: %d\n", this->subproblem_range); 
 
+    if (parser.exists("threads")){
+        this->threads = std::stoi(parser.retrieve<std::string>("threads"));
+        if (this->threads < 1)
+        {
+            printf("Threads should be at least 1\n");
+            exit(-1);
+        }
+    }
+    printf("Threads: %d\n", this->threads);
+
+    if (parser.exists("steady_state"))
+        this->steady_state = true;
+
+    if (parser.exists("parallel_runs"))
+        this->parallel_runs = true;
+
+    if (parser.exists("islands")){
+        this->islands = std::stoi(parser.retrieve<std::string>("islands"));
+        if (this->islands < 1)
+        {
+            printf("Islands should be at least 1\n");
+            exit(-1);
+        }
+    }
+    if (parser.exists("migration")){
+        this->migration = std::stoi(parser.retrieve<std::string>("migration"));
+        if (this->migration < 1)
+        {
+            printf("Migration interval should be at least 1\n");
+            exit(-1);
+        }
+    }
+    if (this->islands > 1)
+        printf("Islands: %d, migration every %d gens\n", this->islands, this->migration);
+    if ((!this->checkpoint.empty() || !this->resume.empty()) && (this->islands > 1 || this->parallel_runs))
+    {
+        printf("Checkpoint and resume do not support islands or parallel runs\n");
+        exit(-1);
+    }
+    if (!this->checkpoint.empty())
+        printf("Checkpoint: %s, every %d sec\n", this->checkpoint.c_str(), this->checkpoint_interval);
+
     int n_num = this->node_num;
     for (int i = 0; i < n_num; i++)
     {
@@ -1086,31 +907,116 @@ void Data::floydWarshall() {
     this->dist = dist_shortest_t;
 }
 
+double Data::relatedness(int i, int j, double r) const
+{
+    auto &node_i = this->node[i];
+    auto &node_j = this->node[j];
+    double tmp_1 = r * std::max(node_j.start - node_i.s_time - this->time[i][j] - node_i.end, 0.0);
+    double tmp_2 = r * PENALTY_FACTOR * std::max(node_i.start + node_i.s_time + this->time[i][j] - node_j.end, 0.0);
+    double tmp_3 = this->dist[i][j];
+    return tmp_3 + tmp_1 + tmp_2;
+}
+
+void Data::build_spatial_index()
+{
+    std::vector<int> customers, stations;
+    for (int i = 0; i < this->node_num; i++)
+    {
+        if (this->node[i].type == 1) customers.push_back(i);
+        else if (this->node[i].type == 2) stations.push_back(i);
+    }
+    this->customer_grid.build(this->node, customers);
+    this->station_grid.build(this->node, stations);
+
+    // dist is given by the instance, the grid can only bound it if it is never shorter than a
+    // fixed multiple of the distance of the coordinates
+    this->dist_lb = double(INFINITY);
+    for (int i = 0; i < this->node_num; i++)
+    {
+        for (int j = 0; j < this->node_num; j++)
+        {
+            double e = std::hypot(this->node[i].x - this->node[j].x, this->node[i].y - this->node[j].y);
+            if (i != j && e > 0.0) this->dist_lb = std::min(this->dist_lb, this->dist[i][j] / e);
+        }
+    }
+    if (!(this->dist_lb > 0.0 && this->dist_lb < double(INFINITY))) this->dist_lb = 0.0;
+}
+
+void Data::rank_stations()
+{
+    /*
+
+    we preprocess the charging stations to rank them for insertion between each pair of nodes.
+    The ranking metric is the extra cost induced by insertion.
+    To balance efficiency and solution quality, only the top sr·|F| ranked charging stations are considered for insertion in both PSI and SSI,
+    so only they are kept. A station at the depot is ranked last next to the depot
+
+    */
+    int n = this->node_num;
+    int sr = this->station_range;
+    int len = std::min(sr + 1, this->station_num);
+    this->optimal_staion.assign(n, std::vector<std::vector<int>>(n, std::vector<int>(sr, 0)));
+    std::vector<int> ranked;
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            if (i == j) continue;
+            // dist[i][k] + dist[k][j] >= 2 * dist_lb * (distance of k to the midpoint - half the distance of i and j)
+            double x = (this->node[i].x + this->node[j].x) / 2.0;
+            double y = (this->node[i].y + this->node[j].y) / 2.0;
+            double slack = std::hypot(this->node[i].x - this->node[j].x, this->node[i].y - this->node[j].y) / 2.0;
+            this->station_grid.smallest(x, y, 2.0 * this->dist_lb, slack, len, [&](int k) {
+                return (k == i || k == j) ? double(INFINITY) : this->dist[i][k] + this->dist[k][j];
+            }, ranked);
+            if (ranked.empty()) continue;
+            int first = 0;
+            if ((i == this->DC && this->dist[i][ranked[0]] == 0) || (j == this->DC && this->dist[ranked[0]][j] == 0))
+                first = 1;
+            for (int k = 0; k < sr; k++) this->optimal_staion[i][j][k] = ranked[(first + k) % len];
+        }
+    }
+}
+
 void Data::pre_processing()
 {
     //printf("--------------------------------------------\n");
+    this->build_spatial_index();
+    this->rank_stations();
     if (this->related_removal)
     {
+        // relatedness is at least dist, so the grid finds the most related customers
         int c_num = this->customer_num;
         int DC = this->DC;
+        int len = std::min(RELATED_NEIGHBOURS, c_num - 1);
+        this->rm_argrank.assign(c_num + 1, std::vector<int>());
         for (int i = 0; i <= c_num; i++)
         {
             if (i == DC) continue;
-            for (int j = 0; j <= c_num; j++)
+            this->customer_grid.smallest(this->node[i].x, this->node[i].y, this->dist_lb, 0.0, len, [&](int j) {
+                return j == i ? double(INFINITY) : this->relatedness(i, j, this->r);
+            }, this->rm_argrank[i]);
+        }
+    }
+    if (this->granular > 0)
+    {
+        // the k most related customers of every customer, kept symmetric so that a move is judged
+        // the same whichever route it is scanned from
+        int c_num = this->customer_num;
+        int k = std::max(std::min(this->granular, c_num - 1), 0);
+        double r = this->alpha * (this->all_dist / this->all_time);
+        this->gm.assign(c_num + 1, std::vector<bool>(c_num + 1, false));
+        std::vector<int> related;
+        for (int i = 1; i <= c_num; i++)
+        {
+            this->customer_grid.smallest(this->node[i].x, this->node[i].y, this->dist_lb, 0.0, k, [&](int j) {
+                return j == i ? double(INFINITY) : this->relatedness(i, j, r);
+            }, related);
+            for (int j : related)
             {
-                if(j == DC || j == i)
-                    this->rm[i][j] = double(INFINITY);
-                else
-                {
-                    auto &node_i = this->node[i];
-                    auto &node_j = this->node[j];
-                    double tmp_1 = this->r * std::max(node_j.start - node_i.s_time - this->time[i][j] - node_i.end, 0.0);
-                    double tmp_2 = this->r * PENALTY_FACTOR * std::max(node_i.start + node_i.s_time + this->time[i][j] - node_j.end, 0.0);
-                    double tmp_3 = this->dist[i][j];
-                    this->rm[i][j] = tmp_3 + tmp_1 + tmp_2;
-                }
+                this->gm[i][j] = true;
+                this->gm[j][i] = true;
             }
-            argsort(this->rm[i], this->rm_argrank[i], c_num+1);
         }
     }
     if (this->pruning)
@@ -1155,33 +1061,3 @@ void Data::pre_processing()
 }
 
 // read over
-
-void Data::clear_mem()
-{
-    for (auto &x : this->mem)
-    {
-        for (auto &move : x.second)
-        {
-            move.len_1 = 0;
-        }
-    }
-}
-
-Move &Data::get_mem(std::string &opt, const int &r1, const int &r2)
-{
-    if (opt == "2opt")
-        return this->mem[opt][r1];
-    else if (opt == "2opt*")
-        return this->mem[opt][r1 * this->vehicle.max_num + r2];
-    else if (opt == "oropt_single")
-        return this->mem[opt][r1];
-    else if (opt == "oropt_double")
-        return this->mem[opt][r1 * this->vehicle.max_num + r2];
-    else if (opt == "2exchange")
-        return this->mem[opt][r1 * this->vehicle.max_num + r2];
-    else
-    {
-        std::cout << "Unknown opt name: " << opt << std::endl;
-        exit(-1); 
-    }
-}
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include "argparse.h"
 #include "util.h"
 #include "move.h"
+#include "spatial.h"
 
 struct Point
 {
@@ -49,11 +50,13 @@ public:
     int station_range;  // the number of charging stations considered, i.e., sr $\in$ (0, 1], the selection range parameter.
     std::vector<std::vector<double>> dist;
     std::vector<std::vector<double>> time;
-    std::vector<std::vector<double>> rm;
-    std::vector<std::vector<int>> rm_argrank;
+    std::vector<std::vector<int>> rm_argrank; // the RELATED_NEIGHBOURS customers most related to each customer, most related first
     std::vector<std::vector<bool>> pm;
-    std::vector<std::vector<std::vector<int>>> optimal_staion;  // preprocess the charging stations to rank them for insertion between each pair of nodes
+    std::vector<std::vector<std::vector<int>>> optimal_staion;  // preprocess the charging stations to rank them for insertion between each pair of nodes, the top station_range of them
     std::vector<std::vector<std::vector<int>>> hyperarc; // record information of "the shortest path in terms of travel time between every pair of nodes" to hyperarc
+    SpatialGrid customer_grid; // grids over the coordinates of customers and stations
+    SpatialGrid station_grid;
+    double dist_lb = 0.0; // dist[i][j] >= dist_lb * (distance of the coordinates of i and j), 0 if there is no such bound
 
     Vehicle vehicle;
     double max_dist = 0; // max value in dist
@@ -82,22 +85,17 @@ public:
     int p_size = P_SIZE; // population size
     int k_init = K; //the number of generated solutions for producing a solution during initialization
     int k_crossover = K; //the number of generated solutions for producing a solution during crossover
-    int ksize = 0;
     int seed = DEFAULT_SEED; // random seed to initialize rng
     double bks = -1.0;       // best known solution
-    std::mt19937 rng; // random number generator
     std::string init = DEFAULT_INIT; // initialization method
     std::string cross_repair = DEFAULT_CROSSOVER; // insertion used in crossover
-    std::tuple<double, double> lambda_gamma = std::make_tuple(0.5,0.5); // params of RCRS method
     std::vector<std::tuple<double, double>> latin;
-    std::string n_insert = ""; //indicate which type-1 insertion should be used, RCRS or TD
 
     std::string selection = DEFAULT_SEL;           //parent selection method
     std::string replacement = DEFAULT_REPLACEMENT; //replacement strategy
 
     double ls_prob = DEFAULT_LS_PROB; //local search probability
     bool skip_finding_lo = DEFAULT_SKIP_FINDING_LO; // if skip finding_local_optima
-    std::map<std::string, std::vector<Move>> mem;
     bool two_opt = DEFAULT_2_OPT; // 2-opt
     std::vector<Move> mem_2opt;
     bool two_opt_star = DEFAULT_2_OPT_STAR; //2-opt*
@@ -110,7 +108,16 @@ public:
 
     int or_opt_len = DEFAULT_OR_OPT_LEN; //max length of seqs relocated by oropt
     int exchange_len = DEFAUTL_EX_LEN;   //max length of seqs exchanged
+    bool route_proximity = DEFAULT_ROUTE_PROXIMITY; // skip route pairs further apart than those holding improving moves
+    bool dirty_routes = DEFAULT_DIRTY_ROUTES; // CDNS keeps the stations and memo entries of routes it left unchanged
+    int granular = DEFAULT_GRANULAR; // k of the granular neighbourhoods of 2-opt*, or-opt and 2-exchange
+    std::vector<std::vector<bool>> gm; // gm[i][j] is true if customer j is among the granular neighbours of i, or i of j
     int subproblem_range = DEFAULT_SUBPROBLEM; // // BCD decomposition. `subproblem = 1` means no decomposition; otherwise, it indicates decomposition.
+    int threads = DEFAULT_THREADS; // number of worker threads
+    bool steady_state = DEFAULT_STEADY_STATE; // asynchronous steady-state memetic search
+    bool parallel_runs = DEFAULT_PARALLEL_RUNS; // concurrent runs
+    int islands = DEFAULT_ISLANDS; // island model
+    int migration = DEFAULT_MIGRATION; // gens between two migrations of the island model
     
     int escape_local_optima = DEFAULT_ELO;            // number of times of escaping local optima
     double destroy_ratio_l = DEFAULT_DESTROY_RATIO_L; //customers to be delete in recombination
@@ -122,20 +129,35 @@ public:
     double alpha = DEFAULT_ALPHA;
     double r = 0.0;
     bool rd_removal_insertion = DEFAULT_RD_R_I;
+    int lns_samples = DEFAULT_LNS_SAMPLES; // destroy-repair samples per (destroy, repair) pair
     bool individual_search = DEFAULT_INDIVIDUAL_SEARCH; // large neighborhood search
     bool population_search = DEFAULT_POPULATION_SEARCH; // memetic search
+    std::vector<double> phase_time; // share of the time per phase, empty means the default schedule
+    bool adaptive_phases = DEFAULT_ADAPTIVE_PHASES; // run the phase improving fastest
+    std::string checkpoint = ""; // checkpoint file, empty means no checkpoint
+    int checkpoint_interval = DEFAULT_CHECKPOINT_INTERVAL; // seconds between two checkpoints
+    std::string resume = ""; // checkpoint file to resume from
+    std::string initial_solution = ""; // solution file or checkpoint to start from instead of the construction
     bool parallel_insertion = DEFAULT_PARALLEL_STATION_INSERTION; // PSI (SSI is used in CDNS by default)
     bool conservative_local_search = DEFAULT_CONSERVATIVE_LOCAL_SEARCH; // CLS
     bool aggressive_local_search = DEFAULT_AGGRESSIVE_LOCAL_SEARCH; // ALS (however, at least one local search should use)
    
 
-    std::vector<std::string> small_opts;
-    std::vector<std::string> destroy_opts;
-    std::vector<std::string> repair_opts;
+    std::vector<SmallOpt> small_opts;
+    std::vector<DestroyOpt> destroy_opts;
+    std::vector<RepairOpt> repair_opts;
     Data(ArgumentParser &parser); // read problem files, set parameters
     Data(const Data& data, std::vector<int> &subproblem); // use to load sub-data to subproblems
     void floydWarshall(); // the Floyd-Warshall algorithm
+    void build_spatial_index();
+    void rank_stations();
     void pre_processing();
-    void clear_mem();
-    Move& get_mem(std::string &opt, const int &r1, const int &r2);
+    double relatedness(int i, int j, double r) const; // relatedness of customer j to customer i, smaller is closer
+
+    // whether a move adding arc (i, j) may be evaluated, arcs from or to the depot and stations always may
+    bool granular_arc(int i, int j) const
+    {
+        if (this->granular == 0 || i == this->DC || j == this->DC || i > this->customer_num || j > this->customer_num) return true;
+        return this->gm[i][j];
+    }
 };
\ No newline at end of file
@@ -1,11 +1,7 @@
 # include "eval.h"
 
-extern long call_count_move_eval;
-extern double mean_duration_move_eval;
-extern double mean_route_len;
-
 using namespace std::chrono;
-void chk_nl_node_pos_O_n(std::vector<int> &nl, int inserted_node, int pos, Data &data, bool &flag, double &cost)
+void chk_nl_node_pos_O_n(std::vector<int> &nl, int inserted_node, int pos, const Data &data, bool &flag, double &cost)
 {
     int len = int(nl.size());
     double capacity = data.vehicle.capacity;
@@ -56,7 +52,7 @@ void chk_nl_node_pos_O_n(std::vector<int> &nl, int inserted_node, int pos, Data
     flag = true;
     cost = data.vehicle.d_cost + distance * data.vehicle.unit_cost;
 }
-void chk_nl_node_pos_O_n(std::vector<int> &nl, int inserted_node, int pos, Data &data, int &flag, double &cost)
+void chk_nl_node_pos_O_n(std::vector<int> &nl, int inserted_node, int pos, const Data &data, int &flag, double &cost)
 {   // suppose insert into the pos
     // also check battery constrain
     // this function contains Charge Amount Calculation without station adjustment
@@ -224,7 +220,70 @@ void chk_nl_node_pos_O_n(std::vector<int> &nl, int inserted_node, int pos, Data
     cost = data.vehicle.d_cost + distance * data.vehicle.unit_cost;
 }
 
-void update_route_status(std::vector<int> &nl, std::vector<status> &sl, Data &data, int &flag, double &cost, int &index_negtive_first)
+/* Charge Amount Calculation at the station nl[i], reached at arr_time with the remaining distance arr_RD.
+Return false if the charge makes a later node miss its time window, otherwise dep_RD is the remaining
+distance on departure */
+static bool charge_amount(const std::vector<int> &nl, int i, double arr_time, double arr_RD, const Data &data, double &dep_RD)
+{
+    // 1. the minimal charge amount required to reach the next station f or depot 0, i.e. q_{f_i, 0}
+    double f_f0_dist=0;
+    int j = i;
+    do{
+        j++;
+        f_f0_dist += data.dist[nl[j-1]][nl[j]];
+    } while (data.node[nl[j]].type == 1);
+
+    // Y_{n_i} will not smaller than y_{n_i}. Here dep_RD = Y_{n_i} / h 
+    dep_RD = std::max(f_f0_dist,arr_RD);  
+    
+    dep_RD = std::min(dep_RD,data.max_distance_reachable); 
+    
+    // 2. the additional charge amount q_{f_i, 1}
+    /*
+    aims to 
+    (1) minimize waiting time by utilizing any available slack time for additional charging.
+    (2) does not affect the arrival time at the next station afther determing q_{f_i, 0}
+    this recursive calculation is O(m_i), faster than O((m_i)^2)
+    */
+    double max_recharge_time = (dep_RD - arr_RD) * data.vehicle.consumption_rate * data.vehicle.recharging_rate; 
+    // (max_recharge_time / g) is q_{f_i} in our paper
+    // (dep_RD - arr_RD) * data.vehicle.consumption_rate is q_{f_i, 0} in our paper
+
+    double min_remain_time = double(INFINITY);                                                                               
+    // min_remain_time is τ_{i,j} in our paper
+    /*
+    the potential available time that can be used to charge when leaving c_{i,j} while satisfying all previous time window constraints.
+    */
+    double move_time = arr_time + max_recharge_time;                                                                   
+    // move_time is equivalent to both a′_{c_{i,j}} and b′_{c_{i,j}}
+    j = i;
+    do{
+        j++;
+        move_time += data.time[nl[j-1]][nl[j]]; // temporely arrival time a′_{c_{i,j}} = b'_{c_{i,j}} + t_{c_{i. j-1}c_{i, j}}
+        // check if there is δ_{i,j} > 0 to use 
+        if (move_time - data.node[nl[j]].start < -PRECISION){
+                double additional_charge_time = std::min(min_remain_time, data.node[nl[j]].start - move_time);   // δ_{i,j} should not be larger than τ_{i,j−1}           
+                // additional_charge_time is δ_{i,j} in our paper 
+                /*
+                the slack time that can be used to charge due to waiting before starting service at c_{i,j}
+                */
+                max_recharge_time += additional_charge_time;  // Note that here we let (g*q_{f_i}) += δ_{i,j} directly
+                move_time += additional_charge_time;          // updated arrival time: move_time = a′_{c_{i,j}} + δ_{i,j} here
+                min_remain_time -= additional_charge_time;    // is equivalent to τ_{i,j−1} - δ_{i,j} here
+        }
+        if (data.node[nl[j]].end - move_time < -PRECISION){   // report that q_{f_i, 0} results in time windows violation prematurely
+            return false;
+        }             
+        min_remain_time = std::min (min_remain_time, data.node[nl[j]].end-move_time);  //  is equivalent to τ_{i,j} = min{τ_{i,j−1}, l_{c_{i,j}} − a′_{c_{i,j}}} − δ_{i,j}
+        if (min_remain_time == 0 ) break;    // the recursive equations can terminate prematurely since the potential available time is 0
+        move_time = std::max(move_time, data.node[nl[j]].start) + data.node[nl[j]].s_time;  // b'_{c_{i,j}} = max{e_{c_{i, j}}, a′_{c_{i,j}} + δ_{i,j}} + s_{c_{i, j}}
+    } while (data.node[nl[j]].type == 1);
+    
+    dep_RD = std::min(max_recharge_time / data.vehicle.recharging_rate / data.vehicle.consumption_rate + arr_RD, data.max_distance_reachable);
+    return true;
+}
+
+void update_route_status(std::vector<int> &nl, std::vector<status> &sl, const Data &data, int &flag, double &cost, int &index_negtive_first)
 {
     /*
     flag == 0 route error
@@ -239,6 +298,8 @@ void update_route_status(std::vector<int> &nl, std::vector<status> &sl, Data &da
 
     // start and end at DC
     if (nl[0] != data.DC || nl[len-1] != data.DC) {flag = 0; return;}
+    if (int(sl.size()) < len) sl.resize(len);
+    sl[0] = status{data.start_time, data.start_time, data.max_distance_reachable, data.max_distance_reachable};
 
     if (len == 2)
     {
@@ -277,62 +338,7 @@ void update_route_status(std::vector<int> &nl, std::vector<status> &sl, Data &da
         sl[i].arr_RD = sl[i-1].dep_RD - data.dist[pre_node][node];   
         if (sl[i].arr_RD < -PRECISION) {flag = 4; index_negtive_first = i; return;}  //electricity-infeasible
         // update sl[i].dep_RD, i.e., Charge Amount Calculation.
-
-        // 1. the minimal charge amount required to reach the next station f or depot 0, i.e. q_{f_i, 0}
-        double f_f0_dist=0;
-        int j = i;
-        do{
-            j++;
-            f_f0_dist += data.dist[nl[j-1]][nl[j]];
-        } while (data.node[nl[j]].type == 1);
-
-        // Y_{n_i} will not smaller than y_{n_i}. Here sl[i].dep_RD = Y_{n_i} / h 
-        sl[i].dep_RD = std::max(f_f0_dist,sl[i].arr_RD);  
-        
-        sl[i].dep_RD = std::min(sl[i].dep_RD,data.max_distance_reachable); 
-        
-        // 2. the additional charge amount q_{f_i, 1}
-        /*
-        aims to 
-        (1) minimize waiting time by utilizing any available slack time for additional charging.
-        (2) does not affect the arrival time at the next station afther determing q_{f_i, 0}
-        this recursive calculation is O(m_i), faster than O((m_i)^2)
-        */
-        double max_recharge_time = (sl[i].dep_RD - sl[i].arr_RD) * data.vehicle.consumption_rate * data.vehicle.recharging_rate; 
-        // (max_recharge_time / g) is q_{f_i} in our paper
-        // (sl[i].dep_RD - sl[i].arr_RD) * data.vehicle.consumption_rate is q_{f_i, 0} in our paper
-
-        double min_remain_time = double(INFINITY);                                                                               
-        // min_remain_time is τ_{i,j} in our paper
-        /*
-        the potential available time that can be used to charge when leaving c_{i,j} while satisfying all previous time window constraints.
-        */
-        double move_time = sl[i].arr_time + max_recharge_time;                                                                   
-        // move_time is equivalent to both a′_{c_{i,j}} and b′_{c_{i,j}}
-        j = i;
-        do{
-            j++;
-            move_time += data.time[nl[j-1]][nl[j]]; // temporely arrival time a′_{c_{i,j}} = b'_{c_{i,j}} + t_{c_{i. j-1}c_{i, j}}
-            // check if there is δ_{i,j} > 0 to use 
-            if (move_time - data.node[nl[j]].start < -PRECISION){
-                    double additional_charge_time = std::min(min_remain_time, data.node[nl[j]].start - move_time);   // δ_{i,j} should not be larger than τ_{i,j−1}           
-                    // additional_charge_time is δ_{i,j} in our paper 
-                    /*
-                    the slack time that can be used to charge due to waiting before starting service at c_{i,j}
-                    */
-                    max_recharge_time += additional_charge_time;  // Note that here we let (g*q_{f_i}) += δ_{i,j} directly
-                    move_time += additional_charge_time;          // updated arrival time: move_time = a′_{c_{i,j}} + δ_{i,j} here
-                    min_remain_time -= additional_charge_time;    // is equivalent to τ_{i,j−1} - δ_{i,j} here
-            }
-            if (data.node[nl[j]].end - move_time < -PRECISION){   // report that q_{f_i, 0} results in time windows violation prematurely
-                flag = 3; return;
-            }             
-            min_remain_time = std::min (min_remain_time, data.node[nl[j]].end-move_time);  //  is equivalent to τ_{i,j} = min{τ_{i,j−1}, l_{c_{i,j}} − a′_{c_{i,j}}} − δ_{i,j}
-            if (min_remain_time == 0 ) break;    // the recursive equations can terminate prematurely since the potential available time is 0
-            move_time = std::max(move_time, data.node[nl[j]].start) + data.node[nl[j]].s_time;  // b'_{c_{i,j}} = max{e_{c_{i, j}}, a′_{c_{i,j}} + δ_{i,j}} + s_{c_{i, j}}
-        } while (data.node[nl[j]].type == 1);
-        
-        sl[i].dep_RD = std::min(max_recharge_time / data.vehicle.recharging_rate / data.vehicle.consumption_rate + sl[i].arr_RD, data.max_distance_reachable);
+        if (!charge_amount(nl, i, sl[i].arr_time, sl[i].arr_RD, data, sl[i].dep_RD)) {flag = 3; return;}
 
         time += (sl[i].dep_RD - sl[i].arr_RD) * data.vehicle.consumption_rate * data.vehicle.recharging_rate;
 
@@ -349,7 +355,7 @@ void update_route_status(std::vector<int> &nl, std::vector<status> &sl, Data &da
 }
 
 
-void update_route_status(bool &evolution, std::vector<int> &nl, std::vector<status> &sl, Data &data, int &flag, double &cost, int &index_negtive_first)
+void update_route_status(bool &evolution, std::vector<int> &nl, std::vector<status> &sl, const Data &data, int &flag, double &cost, int &index_negtive_first)
 {    
     // auto start = high_resolution_clock::now();
     /*
@@ -366,6 +372,8 @@ void update_route_status(bool &evolution, std::vector<int> &nl, std::vector<stat
 
     // start and end at DC
     if (nl[0] != data.DC || nl[len-1] != data.DC) {flag = 0; return;}
+    if (int(sl.size()) < len) sl.resize(len);
+    sl[0] = status{data.start_time, data.start_time, data.max_distance_reachable, data.max_distance_reachable};
 
     if (len == 2)
     {
@@ -502,7 +510,7 @@ void update_route_status(bool &evolution, std::vector<int> &nl, std::vector<stat
 }
 
 
-void chk_route_O_n(Route &r, Data &data, bool &flag, double &cost)
+void chk_route_O_n(Route &r, const Data &data, bool &flag, double &cost)
 {
     // auto start = high_resolution_clock::now();
 
@@ -543,11 +551,11 @@ void chk_route_O_n(Route &r, Data &data, bool &flag, double &cost)
     cost = data.vehicle.d_cost + distance * data.vehicle.unit_cost;
 }
 
-bool eval_route(Solution &s, Seq *seqList, int seqListLen, Attr &tmp_attr, Data &data)
+bool eval_route(Solution &s, Seq *seqList, int seqListLen, Attr &tmp_attr, const Data &data)
 {
-    const Attr &attr_1 = seqList[0].r_index == -1 ? attr_for_one_node(data, seqList[0].start_point) : s.get(seqList[0].r_index).gat(seqList[0].start_point, seqList[0].end_point);
+    const Attr &attr_1 = seqList[0].r_index == -1 ? attr_for_one_node(data, seqList[0].start_point) : s.peek(seqList[0].r_index).gat(seqList[0].start_point, seqList[0].end_point);
 
-    const Attr &attr_2 = seqList[1].r_index == -1 ? attr_for_one_node(data, seqList[1].start_point) : s.get(seqList[1].r_index).gat(seqList[1].start_point, seqList[1].end_point);
+    const Attr &attr_2 = seqList[1].r_index == -1 ? attr_for_one_node(data, seqList[1].start_point) : s.peek(seqList[1].r_index).gat(seqList[1].start_point, seqList[1].end_point);
 
     if ((!check_tw(attr_1, attr_2, data)) || (!check_capacity(attr_1, attr_2, data)))
         return false;
@@ -555,7 +563,7 @@ bool eval_route(Solution &s, Seq *seqList, int seqListLen, Attr &tmp_attr, Data
 
     for (int i = 2; i < seqListLen; i++)
     {
-        const Attr &attr = seqList[i].r_index == -1 ? attr_for_one_node(data, seqList[i].start_point) : s.get(seqList[i].r_index).gat(seqList[i].start_point, seqList[i].end_point);
+        const Attr &attr = seqList[i].r_index == -1 ? attr_for_one_node(data, seqList[i].start_point) : s.peek(seqList[i].r_index).gat(seqList[i].start_point, seqList[i].end_point);
 
         if ((!check_tw(tmp_attr, attr, data)) || (!check_capacity(tmp_attr, attr, data)))
             return false;
@@ -564,13 +572,13 @@ bool eval_route(Solution &s, Seq *seqList, int seqListLen, Attr &tmp_attr, Data
     return true;
 }
 
-bool eval_move(Solution &s, Move &m, Data &data, double &base_cost)
+bool eval_move(Solution &s, Move &m, const Data &data, Workspace &ctx, double &base_cost)
 {
     std::vector<int> r_indice;
     r_indice.push_back(m.r_indice[0]);
     if (m.r_indice[1] != -2)
         r_indice.push_back(m.r_indice[1]);
-    double ori_cost = s.get(r_indice[0]).cal_cost(data);
+    double ori_cost = s.peek(r_indice[0]).peek_cost(data);
 
     if (!data.O_1_evl)  
     {
@@ -581,7 +589,7 @@ bool eval_move(Solution &s, Move &m, Data &data, double &base_cost)
         for (int i = 0; i < m.len_1; i++)
         {
             auto &seq = m.seqList_1[i];
-            auto &source_n_l = s.get(seq.r_index).node_list;
+            auto &source_n_l = s.peek(seq.r_index).node_list;
             for (int index = seq.start_point; index <= seq.end_point; index++)
             {
                 target_n_l.push_back(source_n_l[index]);
@@ -608,7 +616,7 @@ bool eval_move(Solution &s, Move &m, Data &data, double &base_cost)
                     target_n_l.push_back(data.DC);
                     continue;
                 }
-                auto &source_n_l = s.get(seq.r_index).node_list;
+                auto &source_n_l = s.peek(seq.r_index).node_list;
                 for (int index = seq.start_point; index <= seq.end_point; index++)
                 {
                     target_n_l.push_back(source_n_l[index]);
@@ -617,7 +625,7 @@ bool eval_move(Solution &s, Move &m, Data &data, double &base_cost)
             Route r(data);
             r.node_list = target_n_l;
             if (r_indice[1] != -1)
-                ori_cost += s.get(r_indice[1]).cal_cost(data);
+                ori_cost += s.peek(r_indice[1]).peek_cost(data);
             bool flag = false;
             double cost = 0.0;
             chk_route_O_n(r, data, flag, cost);
@@ -643,7 +651,7 @@ bool eval_move(Solution &s, Move &m, Data &data, double &base_cost)
         if (!eval_route(s, m.seqList_2, m.len_2, tmp_attr_2, data))
             return false;
         if (r_indice[1] != -1)
-            ori_cost += s.get(r_indice[1]).cal_cost(data);
+            ori_cost += s.peek(r_indice[1]).peek_cost(data);
         if (tmp_attr_2.num_cus != 0)
             new_cost += data.vehicle.d_cost + tmp_attr_2.dist * data.vehicle.unit_cost;
     }
@@ -662,15 +670,15 @@ bool eval_move(Solution &s, Move &m, Data &data, double &base_cost)
         tour_id_array = apply_move(item, m, data);
         //double used_sec1 = (clock() - stime1) / (CLOCKS_PER_SEC*1.0);
         //printf("time: %.10lf sec\n", used_sec1);
-        double ori_cost = s.get(m.r_indice[0]).total_cost;
-        if (m.r_indice[1] >= 0) ori_cost += s.get(m.r_indice[1]).total_cost;
+        double ori_cost = s.peek(m.r_indice[0]).total_cost;
+        if (m.r_indice[1] >= 0) ori_cost += s.peek(m.r_indice[1]).total_cost;
         double new_cost = 0.0;
         for (auto j: tour_id_array) {
                 if (j >= item.len()) {
-                    if (m.r_indice[0] < item.len() && m.r_indice[1] < item.len()) ori_cost += s.get(j).total_cost;
+                    if (m.r_indice[0] < item.len() && m.r_indice[1] < item.len()) ori_cost += s.peek(j).total_cost;
                     continue;
                 }
-                Route r= item.get(j);
+                Route r= item.peek(j);
                 std::swap(r.node_list, r.customer_list);
                 r.temp_node_list = r.customer_list;
                 int flag = 0;
@@ -679,7 +687,7 @@ bool eval_move(Solution &s, Move &m, Data &data, double &base_cost)
                 update_route_status(r.temp_node_list,r.status_list,data,flag,cost,index_negtive_first); 
                 if (flag == 0 || flag == 2 || flag == 3) return false;
                 if (flag == 1) { item.get(j).total_cost = item.get(j).cal_cost(data); }
-                if (flag == 4 && ! parallel_sequential_station_insertion(item, r, data, j)) return false;
+                if (flag == 4 && ! parallel_sequential_station_insertion(item, r, data, ctx, j)) return false;
                 new_cost += item.get(j).total_cost;
         } 
 
@@ -690,21 +698,22 @@ bool eval_move(Solution &s, Move &m, Data &data, double &base_cost)
         }
         for (int j = 0; j < tour_id_array.size(); j++){
                 if (tour_id_array[j] >= item.len()) continue;
-                m.list[j] = item.get(tour_id_array[j]).node_list;
-                m.total_cost[j] = item.get(tour_id_array[j]).total_cost;
+                m.list[j] = item.peek(tour_id_array[j]).node_list;
+                m.total_cost[j] = item.peek(tour_id_array[j]).total_cost;
         }        
         return true;
     }
     return false;
 }
 
-bool parallel_sequential_station_insertion(Solution &item, Route &r, Data &data, int &j){  // parallel sequential station insertion (PSSI)
+bool parallel_sequential_station_insertion(Solution &item, Route &r, const Data &data, Workspace &ctx, int &j){  // parallel sequential station insertion (PSSI)
+    ctx.reseed(); // a scan of route pairs defers the seed of each pair to the first draw
     double evolution_cost=double(INFINITY);  
     double heuristic_cost=double(INFINITY); 
     int dimension=r.customer_list.size()-1;
     //clock_t stime1 = clock();
     // ----------------------------- parallel station insertion (PSI) -----------------------------------------------------
-    if (data.parallel_insertion) parallel_station_insertion(dimension,r,data,evolution_cost);
+    if (data.parallel_insertion) parallel_station_insertion(dimension,r,data,ctx,evolution_cost);
     //double used_sec1 = (clock() - stime1) / (CLOCKS_PER_SEC*1.0);
     item.get(j).node_list = r.node_list;
     r.temp_node_list=r.customer_list;
@@ -718,13 +727,13 @@ bool parallel_sequential_station_insertion(Solution &item, Route &r, Data &data,
     //double used_sec2 = 0.0;
      
     // ----------------------------- sequential station insertion (SSI) -----------------------------------------------------
-    if (sequential_station_insertion(flag, index_negtive_first, r, data, station_insert_pos, heuristic_cost)){  
+    if (sequential_station_insertion(flag, index_negtive_first, r, data, ctx, station_insert_pos, heuristic_cost)){  
         // best station insertion
         for (int i=0; i<station_insert_pos.size(); i++){
                     r.customer_list.insert(r.customer_list.begin()+ station_insert_pos[i].second, station_insert_pos[i].first); 
         }
         // SSI procedure includes an additional refinement step: improve consecutive stations in route
-        if (r.customer_list.size() >= 4) sequential_station_improvement(heuristic_cost, data, r);
+        if (r.customer_list.size() >= 4) sequential_station_improvement(heuristic_cost, data, ctx, r);
      
     }
     // used_sec2 = (clock() - stime2) / (CLOCKS_PER_SEC*1.0);
@@ -744,11 +753,59 @@ bool parallel_sequential_station_insertion(Solution &item, Route &r, Data &data,
     return true;
 }
 
-void sequential_station_improvement(double &cost, Data &data, Route &r){ // refinement step: improve consecutive stations in route
+int resimulate_route_status(std::vector<int> &nl, std::vector<status> &sl, std::vector<status> &buf, int from, int changed, const Data &data, int &absorbed)
+{
+    /*
+    re-simulate the status of nl from index `from` into buf, where sl[0..from-1] is still valid
+    and sl[from..] holds the status of the feasible route before nl[changed] was replaced.
+    Capacity is not checked since only a station is replaced.
+
+    return flag as in update_route_status, and `absorbed` is the last index re-simulated:
+    once a node after `changed` departs with the same time and remaining distance as in sl,
+    the time shift and battery change are absorbed and the rest of the route is unchanged
+    */
+    int len = int(nl.size());
+    double time = from == 1 ? data.start_time : sl[from-1].dep_time;
+    double dep_RD = sl[from-1].dep_RD;
+    int pre_node = nl[from-1];
+    for (int i = from; i < len; i++)
+    {
+        int node = nl[i];
+        time += data.time[pre_node][node];
+        buf[i].arr_time = time;
+        buf[i].arr_RD = dep_RD - data.dist[pre_node][node];
+
+        if (data.node[node].type != 2){  //customer or depot
+        if (time > data.node[node].end) return 3;
+        time = std::max(time, data.node[node].start) + data.node[node].s_time;
+        if (buf[i].arr_RD < -PRECISION) {absorbed = i; return 4;}
+        buf[i].dep_RD = buf[i].arr_RD;
+        }
+
+        else{  //station
+        if (buf[i].arr_RD < -PRECISION) {absorbed = i; return 4;}
+        if (!charge_amount(nl, i, buf[i].arr_time, buf[i].arr_RD, data, buf[i].dep_RD)) return 3;
+        time += (buf[i].dep_RD - buf[i].arr_RD) * data.vehicle.consumption_rate * data.vehicle.recharging_rate;
+        }
+
+        buf[i].dep_time = time;
+        dep_RD = buf[i].dep_RD;
+        pre_node = node;
+        if (i > changed && time == sl[i].dep_time && dep_RD == sl[i].dep_RD) {absorbed = i; return 1;}
+    }
+    absorbed = len - 1;
+    return 1;
+}
+
+void sequential_station_improvement(double &cost, const Data &data, Workspace &ctx, Route &r){ // refinement step: improve consecutive stations in route
     int flag = 0, j, k, check = 0;
-    double new_cost = 0.0, previous_cost = cost;
+    double new_cost = 0.0, previous_cost = cost, base_cost = 0.0;
     int index_negtive_first = -1;
-    std::vector<int> n_l = r.customer_list;
+    // stations are replaced in place in n_l and undone on failure, r.status_list keeps the status of n_l
+    std::vector<int> &n_l = r.customer_list;
+    update_route_status(n_l, r.status_list, data, flag, base_cost, index_negtive_first);
+    if (flag != 1) return;
+    std::vector<status> buf(n_l.size());
     int first_node, second_node, third_node;
     for (j = 0; j < r.customer_list.size()-2; j++){
             first_node = r.customer_list[j];
@@ -757,44 +814,52 @@ void sequential_station_improvement(double &cost, Data &data, Route &r){ // refi
             if (data.node[second_node].type == 2){   
             //improve r by adjusting the station f_k in the previous result with (c, f_k, f_j ), (f_i, f_k, c), (f_i, f_k, fj ) pattern;
                     if (data.node[first_node].type ==2 || data.node[third_node].type ==2 ){  
+                            // the charge amount of the previous station (if any) depends on f_k, re-simulate from there
+                            int from = j;
+                            while (from > 0 && data.node[n_l[from]].type != 2) from--;
+                            if (from == 0) from = 1;
                             for (k=0; k<data.station_range;k++){
-                                //printf("%d, %d -> %d, %d\n",first_node,second_node,data.optimal_staion[first_node][third_node][k],third_node);
                                 /*
                                 we attempt to replace them with stations based on the preprocessed rankings,
                                 starting from the highest-ranked to lower-ranked stations.
                                 */
-                                if (data.optimal_staion[first_node][third_node][k] == second_node) break;
-                                        n_l[j+1] = data.optimal_staion[first_node][third_node][k];
-                                        r.temp_node_list=n_l;
+                                int station = data.optimal_staion[first_node][third_node][k];
+                                if (station == second_node) break;
+                                        double delta_dist = data.dist[first_node][station] + data.dist[station][third_node] \
+                                                          - data.dist[first_node][second_node] - data.dist[second_node][third_node];
+                                        n_l[j+1] = station;
+                                        int absorbed = -1;
+                                        flag = resimulate_route_status(n_l, r.status_list, buf, from, j+1, data, absorbed);
+                                        if (flag == 3) {n_l[j+1] = second_node; continue;}
+                                        if (flag == 1) {
+                                            new_cost = base_cost + delta_dist * data.vehicle.unit_cost;
+                                            if (new_cost-previous_cost<-PRECISION)  { // If an improvement is found, the replacement is made.
+                                                std::copy(buf.begin() + from, buf.begin() + absorbed + 1, r.status_list.begin() + from);
+                                                cost = new_cost;
+                                                check = 1;
+                                                break;
+                                            }
+                                            n_l[j+1] = second_node;
+                                            continue;
+                                        }
+                                        // flag == 4, the replacement needs additional stations, evaluate the whole route
+                                        r.temp_node_list = n_l;
+                                        n_l[j+1] = second_node;
                                         flag = 0;
                                         new_cost = 0.0;
                                         index_negtive_first = -1;
                                         update_route_status(r.temp_node_list,r.status_list,data,flag,new_cost,index_negtive_first);
-                                        if (flag == 0|| flag==2 || flag == 3) continue;
-                                        if (flag == 4) { 
                                         double heuristic_cost=double(INFINITY);
                                         std::vector<std::pair<int,int>> station_insert_pos;
-                                        station_insert_pos.clear();            
-                                        if (sequential_station_insertion(flag, index_negtive_first, r, data, station_insert_pos, heuristic_cost)){
-                                                for (int index=0; index<station_insert_pos.size(); index++){
-                                                    n_l.insert(n_l.begin()+ station_insert_pos[index].second, station_insert_pos[index].first); 
-                                                }  
-                                                new_cost = heuristic_cost;
-                                                          
-                                        }
-                                        else continue; 
+                                        if (flag == 4 && sequential_station_insertion(flag, index_negtive_first, r, data, ctx, station_insert_pos, heuristic_cost) \
+                                            && heuristic_cost-previous_cost<-PRECISION){
+                                                cost = heuristic_cost;
+                                                n_l = r.temp_node_list;
+                                                check = 1;
+                                                break;
                                         }
-                                        
-                                        if (new_cost-previous_cost<-PRECISION)  { // If an improvement is found, the replacement is made.
-                                            //printf("%d, %d -> %d, %d: %.2lf\n",first_node,second_node,data.optimal_staion[first_node][third_node][k],third_node, new_cost-pre_cost);
-                                            cost = new_cost;
-                                            r.customer_list = n_l;
-                                            check = 1;
-                                            break;
-                                        }    
-                                        else{
-                                            n_l=r.customer_list;
-                                        }                                                   
+                                        // restore the status of n_l
+                                        update_route_status(n_l, r.status_list, data, flag, base_cost, index_negtive_first);
                                 }
 
                                 if (check == 1){
@@ -805,7 +870,7 @@ void sequential_station_improvement(double &cost, Data &data, Route &r){ // refi
     }
 }
 
-std::vector<int> apply_move(Solution &s, Move &m, Data data)
+std::vector<int> apply_move(Solution &s, Move &m, const Data &data)
 {
     std::vector<int> r_indice;
     r_indice.push_back(m.r_indice[0]);
@@ -825,7 +890,7 @@ std::vector<int> apply_move(Solution &s, Move &m, Data data)
     for (int i = 0; i < m.len_1; i++)
     {
         auto &seq = m.seqList_1[i];
-        auto &source_n_l = s.get(seq.r_index).node_list;
+        auto &source_n_l = s.peek(seq.r_index).node_list;
         if (seq.start_point <= seq.end_point)
         {
             for (int index = seq.start_point; index <= seq.end_point; index++)
@@ -854,7 +919,7 @@ std::vector<int> apply_move(Solution &s, Move &m, Data data)
                 target_n_l_2.push_back(data.DC);
                 continue;
             }
-            auto &source_n_l = s.get(seq.r_index).node_list;
+            auto &source_n_l = s.peek(seq.r_index).node_list;
             if (seq.start_point <= seq.end_point)
             {
                 for (int index = seq.start_point; index <= seq.end_point; index++)
@@ -894,7 +959,7 @@ std::vector<int> apply_move(Solution &s, Move &m, Data data)
 }
 
 // "sequential_station_insertion" is implememtation of Best Station Insertion, i.e. w/o refinement
-bool sequential_station_insertion(int &flag, int &index_negtive_first, Route &r, Data &data, std::vector<std::pair<int,int>> &station_insert_pos,double &heuristic_cost){
+bool sequential_station_insertion(int &flag, int &index_negtive_first, Route &r, const Data &data, Workspace &ctx, std::vector<std::pair<int,int>> &station_insert_pos,double &heuristic_cost){
     std::vector<double> score(MAX_STATION_POINT);
     std::vector<int> score_argrank(MAX_STATION_POINT);
     std::vector<int> ties(MAX_STATION_POINT);
@@ -934,7 +999,7 @@ bool sequential_station_insertion(int &flag, int &index_negtive_first, Route &r,
                 else
                     break;
             } //consider the same score
-            if (i > 1) selected = ties[randint(0, i - 1, data.rng)];
+            if (i > 1) selected = ties[randint(0, i - 1, ctx.rng)];
             else selected = ties[0];
             
             int node; 
@@ -975,7 +1040,7 @@ bool sequential_station_insertion(int &flag, int &index_negtive_first, Route &r,
         }
 }
 
-bool cal_score_station(bool type, std::vector<int> &feasible_pos, std::vector<int> &station_pos, std::vector<double> &score, Route &r,Data &data,int index_last_f0, int index_negtive_first)
+bool cal_score_station(bool type, std::vector<int> &feasible_pos, std::vector<int> &station_pos, std::vector<double> &score, Route &r,const Data &data,int index_last_f0, int index_negtive_first)
 {
     if (index_negtive_first == -1) return false;
     int r_len = int(r.temp_node_list.size());
@@ -1053,7 +1118,7 @@ bool cal_score_station(bool type, std::vector<int> &feasible_pos, std::vector<in
 
 }
 
-double criterion_station(Route &r, Data &data, int node, int pos)
+double criterion_station(Route &r, const Data &data, int node, int pos)
 {
     std::vector<int> &nl = r.temp_node_list;
     double alpha=1.0, beta=1.0;
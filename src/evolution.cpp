@@ -8,42 +8,33 @@ Genetic Algorithm for Parallel Station Insertion
 #include <algorithm>
 
 int MAXITERA = 5;  // B = 5
-int POPSIZE;
-double DELTA;
 
-struct Candidate
-{
-    int x[100];
-    std::vector<int> node_list;
-    double fitx;
-} individual[301], best_r;
-
-bool check_adjustment(int dimension, Route &r, Data &data, int idx) {
+bool check_adjustment(int dimension, Route &r, const Data &data, Workspace &ctx, int idx) {
     bool evolution = true;
     // generate valid solutions
-    individual[idx].node_list = r.customer_list;
+    ctx.individual[idx].node_list = r.customer_list;
     for (int j = dimension; j >= 1; --j) {
-        if (individual[idx].x[j - 1] == 1) {
-            int pre = individual[idx].node_list[j - 1];
-            int post = individual[idx].node_list[j];
-            individual[idx].node_list.insert(individual[idx].node_list.begin() + j, data.optimal_staion[pre][post][0]);
+        if (ctx.individual[idx].x[j - 1] == 1) {
+            int pre = ctx.individual[idx].node_list[j - 1];
+            int post = ctx.individual[idx].node_list[j];
+            ctx.individual[idx].node_list.insert(ctx.individual[idx].node_list.begin() + j, data.optimal_staion[pre][post][0]);
         }
     }
 
     int flag = 0;
     double new_cost = 0.0;
     int index_negtive_first = -1;
-    update_route_status(evolution, individual[idx].node_list, r.status_list, data, flag, new_cost, index_negtive_first);
+    update_route_status(evolution, ctx.individual[idx].node_list, r.status_list, data, flag, new_cost, index_negtive_first);
     
     if (flag != 1) return false;
-    individual[idx].fitx = new_cost;
+    ctx.individual[idx].fitx = new_cost;
     return true;
 }
 
-bool initialization(int &dimension, Route &r, Data &data) {
+bool initialization(int &dimension, Route &r, const Data &data, Workspace &ctx) {
     int cnt = 0, last = -1;
 
-    for (int i = 0; i < POPSIZE; ++i) {
+    for (int i = 0; i < ctx.popsize; ++i) {
 
 
         if (last != i) {
@@ -51,43 +42,43 @@ bool initialization(int &dimension, Route &r, Data &data) {
             cnt = 0;
         } else {
             ++cnt;
-            if (cnt > DELTA) {
+            if (cnt > ctx.delta) {
                 if (i == 0) {
                     return false;
                 } else {
-                    for (int k = i; k < POPSIZE; ++k) {
-                        individual[k] = individual[randint(0, i - 1, data.rng)];
+                    for (int k = i; k < ctx.popsize; ++k) {
+                        ctx.individual[k] = ctx.individual[randint(0, i - 1, ctx.rng)];
                     }
                     break;
                 }
             }
         }
         
-        std::generate(individual[i].x, individual[i].x + dimension, [&data]() {
-            return rand(0, 1, data.rng) < 0.5 ? 1 : 0;
+        std::generate(ctx.individual[i].x, ctx.individual[i].x + dimension, [&ctx]() {
+            return rand(0, 1, ctx.rng) < 0.5 ? 1 : 0;
         });
 
-        if (!check_adjustment(dimension, r, data, i)) {
+        if (!check_adjustment(dimension, r, data, ctx, i)) {
             --i;
             continue;
         }
     }
 
-    best_r = *std::min_element(individual, individual + POPSIZE, [](const Candidate& a, const Candidate& b) {
+    ctx.best_r = *std::min_element(ctx.individual.begin(), ctx.individual.begin() + ctx.popsize, [](const Candidate& a, const Candidate& b) {
         return a.fitx < b.fitx;
     });
 
     return true;
 }
 
-bool evolution(int &dimension, Route &r, Data &data) {
+bool evolution(int &dimension, Route &r, const Data &data, Workspace &ctx) {
     int flag = 0;
     double new_cost = 0.0;
     int index_negtive_first = -1;
     bool evolution = true;
     int cnt = 0, last = -1;
 
-    for (int i = 0; i < POPSIZE; ++i) {
+    for (int i = 0; i < ctx.popsize; ++i) {
 
         
         if (last != i) {
@@ -95,58 +86,58 @@ bool evolution(int &dimension, Route &r, Data &data) {
             cnt = 0;
         } else {
             ++cnt;
-            if (cnt > DELTA) {
+            if (cnt > ctx.delta) {
                 return i > 0;
             }
         }
 
         // selection
-        int p1 = randint(0, POPSIZE - 1, data.rng);
-        int p2 = randint(0, POPSIZE - 1, data.rng);
+        int p1 = randint(0, ctx.popsize - 1, ctx.rng);
+        int p2 = randint(0, ctx.popsize - 1, ctx.rng);
         
         for (int j = 0; j < dimension; ++j) {
             // crossover 
-            individual[POPSIZE].x[j] = individual[p1].x[j] ^ individual[p2].x[j];
+            ctx.individual[ctx.popsize].x[j] = ctx.individual[p1].x[j] ^ ctx.individual[p2].x[j];
             // mutation
-            if (rand(0, 1, data.rng) < 0.02) {
-                individual[POPSIZE].x[j] ^= 1;
+            if (rand(0, 1, ctx.rng) < 0.02) {
+                ctx.individual[ctx.popsize].x[j] ^= 1;
             }
-            if (individual[POPSIZE].x[j] == 1 && rand(0, 1, data.rng) < 0.2) {
-                individual[POPSIZE].x[j] = 0;
+            if (ctx.individual[ctx.popsize].x[j] == 1 && rand(0, 1, ctx.rng) < 0.2) {
+                ctx.individual[ctx.popsize].x[j] = 0;
             }
             
         }
 
-        if (!check_adjustment(dimension, r, data, POPSIZE)) {
+        if (!check_adjustment(dimension, r, data, ctx, ctx.popsize)) {
             --i;
             continue;
         }
         
         // replacement
-        if (individual[POPSIZE].fitx < individual[i].fitx) {
-            individual[i] = individual[POPSIZE];
-            if (individual[i].fitx < best_r.fitx) {
-                best_r = individual[i];
+        if (ctx.individual[ctx.popsize].fitx < ctx.individual[i].fitx) {
+            ctx.individual[i] = ctx.individual[ctx.popsize];
+            if (ctx.individual[i].fitx < ctx.best_r.fitx) {
+                ctx.best_r = ctx.individual[i];
             }
         }
     }
     return true;
 }
 
-bool parallel_station_insertion(int &dimension, Route &r, Data &data, double &evolution_cost) {
+bool parallel_station_insertion(int &dimension, Route &r, const Data &data, Workspace &ctx, double &evolution_cost) {
     
-    POPSIZE = dimension * 3;      // alpha = 3
-    DELTA = POPSIZE * MAXITERA;   // break out PSI if it is always infeasible
+    ctx.popsize = dimension * 3;      // alpha = 3
+    ctx.delta = ctx.popsize * MAXITERA;   // break out PSI if it is always infeasible
 
-    if (!initialization(dimension, r, data)) return false;
+    if (!initialization(dimension, r, data, ctx)) return false;
 
     int gen = 0;
     while (gen < MAXITERA) {
-        if (!evolution(dimension, r, data)) break;
+        if (!evolution(dimension, r, data, ctx)) break;
         ++gen;
     }
 
-    r.node_list = best_r.node_list;
-    evolution_cost = best_r.fitx;
+    r.node_list = ctx.best_r.node_list;
+    evolution_cost = ctx.best_r.fitx;
     return true;
 }
\ No newline at end of file
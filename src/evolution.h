@@ -16,4 +16,5 @@
 #include "config.h"
 #include "eval.h"
 #include "move.h"
-bool parallel_station_insertion(int &dimension, Route &r, Data &data, double &evolution_cost);
\ No newline at end of file
+#include "context.h"
+bool parallel_station_insertion(int &dimension, Route &r, const Data &data, Workspace &ctx, double &evolution_cost);
\ No newline at end of file
@@ -1,40 +1,14 @@
 #include "evrp_tw_spd_solver.h"
-Solution best_s;
-double best_s_cost;
-clock_t find_best_time;
-int find_best_run;
-int find_best_gen;
-clock_t find_bks_time;
-int find_bks_run;
-int find_bks_gen;
-bool find_better;
-long call_count_move_eval;
-double mean_duration_move_eval;
-double mean_route_len;
-
 
+// only async-signal-safe work here: the search stops at its next deadline check and returns
+// from its gen loop, main then reports and writes the latest checkpoint
 void signalHandler(int signum)
 {
-    printf("Interrupt signal (%d) received.\n", signum);
-    printf("Best cost: %.4f.\n", best_s_cost);
-    printf("Time to find this solution: %d.\n", int(find_best_time));
-    printf("Time to surpass BKS: %d.\n", int(find_bks_time));
-    exit(signum);
+    interrupted = signum;
 }
 
 int main(int argc, char **argv)
 {
-    best_s.cost = double(INFINITY);
-    best_s_cost = -1.0;
-    find_best_time = find_bks_time = 0;
-    find_best_run = find_bks_run = 0;
-    find_best_gen = find_bks_gen = 0;
-    find_better = false;
-    call_count_move_eval = 0;
-    mean_duration_move_eval = 0.0;
-    mean_route_len = 0.0;
-    signal(SIGINT, signalHandler);
-    signal(SIGTERM, signalHandler);
     ArgumentParser parser;
     // required arguments
     parser.addArgument("--problem", 1, false);
@@ -69,23 +43,63 @@ int main(int argc, char **argv)
     parser.addArgument("--regret_insertion");
     parser.addArgument("--greedy_insertion");
     parser.addArgument("--rd_removal_insertion");
+    parser.addArgument("--lns_samples", 1);
+    parser.addArgument("--granular", 1);
+    parser.addArgument("--route_proximity");
+    parser.addArgument("--dirty_routes");
     parser.addArgument("--bks", 1);
     parser.addArgument("--random_seed", 1);
 
     parser.addArgument("--individual_search"); 
     parser.addArgument("--population_search"); 
+    parser.addArgument("--phase_time", 1); 
+    parser.addArgument("--adaptive_phases"); 
+    parser.addArgument("--checkpoint", 1); 
+    parser.addArgument("--checkpoint_interval", 1); 
+    parser.addArgument("--resume", 1); 
+    parser.addArgument("--initial_solution", 1); 
     parser.addArgument("--parallel_insertion"); 
     parser.addArgument("--conservative_local_search"); 
     parser.addArgument("--aggressive_local_search"); 
     parser.addArgument("--station_range", 1); 
     parser.addArgument("--subproblem_range", 1); 
+    parser.addArgument("--threads", 1); 
+    parser.addArgument("--steady_state"); 
+    parser.addArgument("--islands", 1); 
+    parser.addArgument("--parallel_runs"); 
+    parser.addArgument("--migration", 1); 
 
     // parse the command-line arguments - throws if invalid format
     parser.parse(argc, argv);
     // Load data and preprocess
     Data data(parser);
+    SearchContext ctx(data);
+    SearchState state;
+    if (!data.resume.empty())
+    {
+        load_checkpoint(data.resume, data, state, ctx);
+        ctx.resume = &state;
+    }
+    if (!data.checkpoint.empty())
+        ctx.checkpointer = new Checkpointer(data);
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
     // Hybrid Memetic Search (HMA)
-    search_framework(data, best_s, 1, -1, -1); 
+    if (data.islands > 1 || data.parallel_runs)
+        concurrent_search(data, ctx);
+    else
+        search_framework(data, ctx, ctx.best_s, 1, -1, -1); 
 
+    // every search has returned, no worker thread is left to touch ctx
+    if (interrupted)
+    {
+        printf("Interrupt signal (%d) received.\n", int(interrupted));
+        printf("Best cost: %.4f.\n", ctx.best_s.cost);
+        printf("Time to find this solution: %d.\n", int(ctx.find_best_time));
+        printf("Time to surpass BKS: %d.\n", int(ctx.find_bks_time));
+        if (ctx.checkpointer != nullptr && ctx.checkpointer->write())
+            printf("Checkpoint written.\n");
+        return interrupted;
+    }
     return 0;
 }
\ No newline at end of file
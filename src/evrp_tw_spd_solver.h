@@ -5,4 +5,5 @@
 #include "argparse.h"
 #include "data.h"
 #include "solution.h"
-#include "search_framework.h"
\ No newline at end of file
+#include "search_framework.h"
+#include "checkpoint.h"
\ No newline at end of file
@@ -1,20 +1,49 @@
 #include "operator.h"
-// for preventing memory allocation
-Move tmp_move;
-// map from string to opt;
-std::map<std::string, std::function<void(int, int, Solution&, Data&, Move&, double&)>>
-small_opt_map = {
-    {"2opt", two_opt},
-    {"2opt*", two_opt_star},
-    {"oropt_single", or_opt_single},
-    {"oropt_double", or_opt_double},
-    {"2exchange", two_exchange}};
-std::map<std::string, std::function<void(Solution &, Data &)>>
-destroy_opt_map = {{"random_removal", random_removal},
-                   {"related_removal", related_removal}};
-std::map<std::string, std::function<void(Solution &, Data &)>>
-repair_opt_map = {{"regret_insertion", regret_insertion},
-                  {"greedy_insertion", greedy_insertion}};
+#include <cstring>
+// destroy and repair opts, indexed by DestroyOpt and RepairOpt
+typedef void (*DestroyFn)(Solution &, const Data &, SearchContext &);
+typedef void (*RepairFn)(Solution &, const Data &, Workspace &);
+static const DestroyFn destroy_opt_table[] = {random_removal, related_removal};
+static const RepairFn repair_opt_table[] = {regret_insertion, greedy_insertion};
+static_assert(sizeof(destroy_opt_table) / sizeof(DestroyFn) == DESTROY_OPT_NUM, "register every DestroyOpt");
+static_assert(sizeof(repair_opt_table) / sizeof(RepairFn) == REPAIR_OPT_NUM, "register every RepairOpt");
+
+// inter-route moves checked and skipped by the granular neighbourhoods, over all threads
+static std::atomic<long> granular_checked(0), granular_skipped(0);
+
+static void count_granular(const Data &data, long checked, long skipped)
+{
+    if (data.granular == 0) return;
+    granular_checked.fetch_add(checked, std::memory_order_relaxed);
+    granular_skipped.fetch_add(skipped, std::memory_order_relaxed);
+}
+
+void granular_stats(long &checked, long &skipped)
+{
+    checked = granular_checked.load();
+    skipped = granular_skipped.load();
+}
+
+// route pairs listed and skipped by the proximity filter, over all threads
+static std::atomic<long> proximity_checked(0), proximity_skipped(0);
+
+void route_proximity_stats(long &checked, long &skipped)
+{
+    checked = proximity_checked.load();
+    skipped = proximity_skipped.load();
+}
+
+// with --dirty_routes, sub-neighborhoods listed and those skipped as known to hold no improving move,
+// and routes entering CDNS and those it left unchanged since its last call, over all threads
+static std::atomic<long> memo_listed(0), memo_reused(0), cdns_routes(0), cdns_clean(0);
+
+void dirty_route_stats(long &listed, long &reused, long &routes, long &clean)
+{
+    listed = memo_listed.load();
+    reused = memo_reused.load();
+    routes = cdns_routes.load();
+    clean = cdns_clean.load();
+}
 
 bool iscustomerlist(const std::vector<int>& s1, const std::vector<int>& s2) {
 
@@ -33,7 +62,7 @@ bool iscustomerlist(const std::vector<int>& s1, const std::vector<int>& s2) {
     return false; 
 }
 
-void maintain_unrouted(int i, int node, int &index, std::vector<std::tuple<int, int>> &unrouted, double &unrouted_d, double &unrouted_p, Data &data)
+void maintain_unrouted(int i, int node, int &index, std::vector<std::tuple<int, int>> &unrouted, double &unrouted_d, double &unrouted_p, const Data &data)
 {
     unrouted[i] = unrouted[index-1];
     index--;
@@ -41,7 +70,7 @@ void maintain_unrouted(int i, int node, int &index, std::vector<std::tuple<int,
     unrouted_p -= data.node[node].pickup;
 }
 
-double cal_tc(std::vector<int> &nl, int inserted_node, int pos, double unrouted_d, double unrouted_p, Data &data)
+double cal_tc(std::vector<int> &nl, int inserted_node, int pos, double unrouted_d, double unrouted_p, const Data &data, Workspace &ctx)
 {
     int ori_len = int(nl.size());
     int new_len = ori_len + 1;
@@ -61,11 +90,11 @@ double cal_tc(std::vector<int> &nl, int inserted_node, int pos, double unrouted_
     route_d += data.node[inserted_node].delivery;
     route_p += data.node[inserted_node].pickup;
 
-    static std::vector<double> rd(MAX_NODE_IN_ROUTE);
-    static std::vector<double> rp(MAX_NODE_IN_ROUTE);
-    static std::vector<double> load(MAX_NODE_IN_ROUTE);
-    static std::vector<double> cd(MAX_NODE_IN_ROUTE);
-    static std::vector<double> cp(MAX_NODE_IN_ROUTE);
+    std::vector<double> &rd = ctx.rd;
+    std::vector<double> &rp = ctx.rp;
+    std::vector<double> &load = ctx.load;
+    std::vector<double> &cd = ctx.cd;
+    std::vector<double> &cp = ctx.cp;
 
     load[0] = route_d;
     cd[0] = 0.0;
@@ -132,26 +161,26 @@ double cal_tc(std::vector<int> &nl, int inserted_node, int pos, double unrouted_
     return tc;
 }
 
-double criterion(Route &r, Data &data, int node, int pos, double unrouted_d, double unrouted_p)
+double criterion(Route &r, const Data &data, Workspace &ctx, int node, int pos, double unrouted_d, double unrouted_p)
 {
     std::vector<int> &nl = r.temp_node_list;
     // TD
     int pre = nl[pos-1];
     int suc = nl[pos];
     double td = data.dist[pre][node] + data.dist[node][suc] - data.dist[pre][suc];
-    if (data.n_insert == TD) return td;
+    if (ctx.n_insert == TD) return td;
 
     // TC
     // std::vector<int> tmp_nl = r.node_list;
     // tmp_nl.insert(tmp_nl.begin() + pos, node);
-    double tc = cal_tc(r.temp_node_list, node, pos, unrouted_d, unrouted_p, data);
+    double tc = cal_tc(r.temp_node_list, node, pos, unrouted_d, unrouted_p, data, ctx);
 
     // RS
     double rs = data.dist[data.DC][node] + data.dist[node][data.DC];
 
     // RCRS
-    double rcrs = td + std::get<0>(data.lambda_gamma) * tc * (2 * data.max_dist - data.min_dist) -
-                  std::get<1>(data.lambda_gamma) * rs;
+    double rcrs = td + std::get<0>(ctx.lambda_gamma) * tc * (2 * data.max_dist - data.min_dist) -
+                  std::get<1>(ctx.lambda_gamma) * rs;
 
     return rcrs;
 }
@@ -159,7 +188,7 @@ double criterion(Route &r, Data &data, int node, int pos, double unrouted_d, dou
 
 bool cal_score(std::vector<int> &feasible_pos, std::vector<std::tuple<int, int>> &unrouted, \
                         std::vector<double> &score, std::vector<int> &unrouted_index,\
-                        int &score_len, int index, Route &r, double unrouted_d, double unrouted_p, Data &data)
+                        int &score_len, int index, Route &r, double unrouted_d, double unrouted_p, const Data &data, Workspace &ctx)
 {    
 
     /* calculate insertion criterion for each node in unrouted, return
@@ -201,7 +230,7 @@ bool cal_score(std::vector<int> &feasible_pos, std::vector<std::tuple<int, int>>
         { 
             if (feasible_pos[i*MAX_NODE_IN_ROUTE+pos] != relax) continue;
             //if (feasible_pos[i*MAX_NODE_IN_ROUTE+pos] == 0) continue;
-            double utility = criterion(r, data, node, pos, unrouted_d, unrouted_p);
+            double utility = criterion(r, data, ctx, node, pos, unrouted_d, unrouted_p);
             if (utility - best_score < -PRECISION)
             {
                 best_score = utility;
@@ -220,24 +249,38 @@ bool cal_score(std::vector<int> &feasible_pos, std::vector<std::tuple<int, int>>
 }
 
 
-void find_unrouted(Solution &s, std::vector<int> &record)
+void find_unrouted(Solution &s, const Data &data, std::vector<int> &record)
 {
-    int len = s.len();
-    for (int i = 0; i < len; i++)
+    // record[c] = 1 for the customers c served by s
+    int route, pos;
+    for (int c = 0; c < int(record.size()); c++)
     {
-        Route &r = s.get(i);
-        for (auto node : r.node_list)
-        {    
-            if (node < record.size()) record[node] = 1;
-        }
+        if (data.node[c].type == 1 && s.locate(c, data, route, pos)) record[c] = 1;
     }
 }
 
+// routes serving the customers c with flag[c] == 1, ascending
+static std::vector<int> routes_of(Solution &s, const Data &data, const std::vector<int> &flag)
+{
+    std::vector<char> in(s.len(), 0);
+    int route, pos;
+    for (int c = 0; c < int(flag.size()); c++)
+    {
+        if (flag[c] == 1 && data.node[c].type == 1 && s.locate(c, data, route, pos)) in[route] = 1;
+    }
+    std::vector<int> routes;
+    for (int r = 0; r < s.len(); r++)
+    {
+        if (in[r]) routes.push_back(r);
+    }
+    return routes;
+}
+
 
 
 void update_nodes_pm_cost(Solution &s, std::vector<std::vector<int>> &nodes_pm_pos, std::vector<std::vector<double>> &nodes_pm_cost, \
                        std::vector<std::vector<std::vector<std::pair<int,int>>>> &nodes_pm_station_insert_pos, \
-                       std::vector<int> &unrouted_nodes, Data &data)
+                       std::vector<int> &unrouted_nodes, const Data &data, Workspace &ctx)
 {
     for (int i = 0; i < int(unrouted_nodes.size()); i++)
     {
@@ -268,7 +311,7 @@ void update_nodes_pm_cost(Solution &s, std::vector<std::vector<int>> &nodes_pm_p
             }
             exit(-1);
         }
-        else if (flag == 4 && !sequential_station_insertion(flag, index_negtive_first, r, data, station_insert_pos, new_cost)){
+        else if (flag == 4 && !sequential_station_insertion(flag, index_negtive_first, r, data, ctx, station_insert_pos, new_cost)){
             printf("Error: Detect not feasible 1-customer route: ");
             for (auto &node : tmp_nl)
             {
@@ -303,7 +346,7 @@ void update_nodes_pm_cost(Solution &s, std::vector<std::vector<int>> &nodes_pm_p
                 update_route_status(r.temp_node_list,r.status_list,data,flag,new_cost,index_negtive_first); 
                 std::vector<std::pair<int,int>> station_insert_pos;
                 station_insert_pos.clear(); 
-                if (flag == 1 || (flag == 4 && sequential_station_insertion(flag, index_negtive_first, r, data, station_insert_pos, new_cost)) ){
+                if (flag == 1 || (flag == 4 && sequential_station_insertion(flag, index_negtive_first, r, data, ctx, station_insert_pos, new_cost)) ){
                     double incur_cost = new_cost - ori_cost;
                     if (incur_cost - best_incur_cost < -PRECISION)
                     {
@@ -325,7 +368,7 @@ void update_nodes_pm_cost(Solution &s, std::vector<std::vector<int>> &nodes_pm_p
 void update_single_node_pm_cost(Solution &s, std::vector<std::vector<int>> &nodes_pm_pos, \
                                  std::vector<std::vector<double>> &nodes_pm_cost, \
                                  std::vector<std::vector<std::vector<std::pair<int,int>>>> &nodes_pm_station_insert_pos, \
-                                 std::vector<int> &unrouted_nodes, int changed_r_index, std::vector<bool> &inserted, Data &data)
+                                 std::vector<int> &unrouted_nodes, int changed_r_index, std::vector<bool> &inserted, const Data &data, Workspace &ctx)
 {
     Route &r = s.get(changed_r_index);
     double ori_cost = r.cal_cost(data);
@@ -354,7 +397,7 @@ void update_single_node_pm_cost(Solution &s, std::vector<std::vector<int>> &node
             update_route_status(r.temp_node_list,r.status_list,data,flag,new_cost,index_negtive_first); 
             std::vector<std::pair<int,int>> station_insert_pos;
             station_insert_pos.clear(); 
-            if (flag == 1 || (flag == 4 && sequential_station_insertion(flag, index_negtive_first, r, data, station_insert_pos, new_cost)) ){
+            if (flag == 1 || (flag == 4 && sequential_station_insertion(flag, index_negtive_first, r, data, ctx, station_insert_pos, new_cost)) ){
                 double incur_cost = new_cost - ori_cost;
                 if (incur_cost - best_incur_cost < -PRECISION)
                 {
@@ -370,7 +413,7 @@ void update_single_node_pm_cost(Solution &s, std::vector<std::vector<int>> &node
     }
 }
 
-void update_nodes_pm_cost(Solution &s, std::vector<std::vector<int>> &nodes_pm_pos, std::vector<std::vector<double>> &nodes_pm_cost, std::vector<int> &unrouted_nodes, Data &data)
+void update_nodes_pm_cost(Solution &s, std::vector<std::vector<int>> &nodes_pm_pos, std::vector<std::vector<double>> &nodes_pm_cost, std::vector<int> &unrouted_nodes, const Data &data)
 {
     // VRP-TW-SPD version
     for (int i = 0; i < int(unrouted_nodes.size()); i++)
@@ -425,7 +468,7 @@ void update_nodes_pm_cost(Solution &s, std::vector<std::vector<int>> &nodes_pm_p
         }
     }
 }
-void update_single_node_pm_cost(Solution &s, std::vector<std::vector<int>> &nodes_pm_pos, std::vector<std::vector<double>> &nodes_pm_cost, std::vector<int> &unrouted_nodes, int changed_r_index, std::vector<bool> &inserted, Data &data)
+void update_single_node_pm_cost(Solution &s, std::vector<std::vector<int>> &nodes_pm_pos, std::vector<std::vector<double>> &nodes_pm_cost, std::vector<int> &unrouted_nodes, int changed_r_index, std::vector<bool> &inserted, const Data &data)
 {
     // VRP-TW-SPD version
     Route &r = s.get(changed_r_index);
@@ -461,12 +504,12 @@ void update_single_node_pm_cost(Solution &s, std::vector<std::vector<int>> &node
     }
 }
 
-void greedy_insertion(Solution &s, Data &data)
+void greedy_insertion(Solution &s, const Data &data, Workspace &)
 {
     int num_cus = data.customer_num;
     // find all unrouted nodes
     std::vector<int> record(num_cus + 1, 0);
-    find_unrouted(s, record);
+    find_unrouted(s, data, record);
     std::vector<int> unrouted_nodes;
     unrouted_nodes.reserve(data.customer_num);
 
@@ -563,12 +606,12 @@ void greedy_insertion(Solution &s, Data &data)
     s.cal_cost(data);
 }
 
-void regret_insertion(Solution &s, Data &data)
+void regret_insertion(Solution &s, const Data &data, Workspace &ctx)
 {
     int num_cus = data.customer_num;
     // find all unrouted nodes
     std::vector<int> record(num_cus + 1, 0);
-    find_unrouted(s, record);
+    find_unrouted(s, data, record);
     std::vector<int> unrouted_nodes;
     unrouted_nodes.reserve(data.customer_num);
 
@@ -598,7 +641,7 @@ void regret_insertion(Solution &s, Data &data)
     }
     // calculate regert value of each customer node
     // printf("before calculate\n");
-    update_nodes_pm_cost(s, nodes_pm_pos, nodes_pm_cost, nodes_pm_station_insert_pos, unrouted_nodes, data);
+    update_nodes_pm_cost(s, nodes_pm_pos, nodes_pm_cost, nodes_pm_station_insert_pos, unrouted_nodes, data, ctx);
     // printf("sucessfully calculate\n");
     while (unroute_len > 0)
     {
@@ -706,13 +749,13 @@ void regret_insertion(Solution &s, Data &data)
         int changed_r_index = best_route_index;
         if (changed_r_index == -1) changed_r_index = s.len() - 1;
         // printf("changed_r_index: %d\n",changed_r_index);
-        update_single_node_pm_cost(s, nodes_pm_pos, nodes_pm_cost, nodes_pm_station_insert_pos, unrouted_nodes, changed_r_index, inserted, data);
+        update_single_node_pm_cost(s, nodes_pm_pos, nodes_pm_cost, nodes_pm_station_insert_pos, unrouted_nodes, changed_r_index, inserted, data, ctx);
         // exit(0);
     }
     s.cal_cost(data);
 }
 
-void new_route_insertion(Solution &s, Data &data, int initial_node)
+void new_route_insertion(Solution &s, const Data &data, Workspace &ctx, int initial_node)
 {
     std::vector<double> score(MAX_POINT);
     std::vector<int> score_argrank(MAX_POINT);
@@ -726,7 +769,7 @@ void new_route_insertion(Solution &s, Data &data, int initial_node)
     // find all unrouted customers
     // index points to the last position
     std::vector<int> record(num_cus + 1, 0);
-    find_unrouted(s, record);
+    find_unrouted(s, data, record);
 
     // first dim: node, second dim: position
     std::vector<std::tuple<int, int>> unrouted(data.customer_num);
@@ -770,7 +813,7 @@ void new_route_insertion(Solution &s, Data &data, int initial_node)
         }
         else  // not the first time into this loop
         {
-            selected = randint(0, index-1, data.rng);
+            selected = randint(0, index-1, ctx.rng);
             first_node = std::get<0>(unrouted[selected]);
         }
         // try to insert the fisrt customer in the route, best station insertion ("sequential_station_insertion" here is without refinement)
@@ -790,7 +833,7 @@ void new_route_insertion(Solution &s, Data &data, int initial_node)
             printf("No solution.");
             exit(0);
         }
-        if (flag == 4 && !sequential_station_insertion(flag, index_negtive_first, r, data, station_insert_pos, new_cost)) continue;
+        if (flag == 4 && !sequential_station_insertion(flag, index_negtive_first, r, data, ctx, station_insert_pos, new_cost)) continue;
         maintain_unrouted(selected, first_node, index, unrouted, unrouted_d, unrouted_p, data);
         r.node_list.insert(r.node_list.begin() + 1, first_node);  
         for (int i = 0; i < station_insert_pos.size(); i++){  // the same insertion order
@@ -800,7 +843,7 @@ void new_route_insertion(Solution &s, Data &data, int initial_node)
         int score_len = 0;
         partial_cost = new_cost;
         while (cal_score(feasible_pos, unrouted, score, unrouted_index, score_len, index, r,
-                         unrouted_d, unrouted_p, data))
+                         unrouted_d, unrouted_p, data, ctx))
         {   
             argsort(score, score_argrank, score_len);
             int count = 0 , node, pos, selected;
@@ -816,7 +859,7 @@ void new_route_insertion(Solution &s, Data &data, int initial_node)
             flag = 0, new_cost = 0.0, index_negtive_first = -1;
             update_route_status(r.temp_node_list,r.status_list,data,flag,new_cost,index_negtive_first);  
             station_insert_pos.clear();
-            }while (flag == 4 && !sequential_station_insertion(flag, index_negtive_first, r, data, station_insert_pos, new_cost) && count < score_len);
+            }while (flag == 4 && !sequential_station_insertion(flag, index_negtive_first, r, data, ctx, station_insert_pos, new_cost) && count < score_len);
             if (flag != 1) break;
             maintain_unrouted(selected, node, index, unrouted, unrouted_d, unrouted_p, data);
             r.node_list = r.temp_node_list;
@@ -827,13 +870,13 @@ void new_route_insertion(Solution &s, Data &data, int initial_node)
     }
 }
 
-void new_route_insertion(Solution &s, Data &data)
+void new_route_insertion(Solution &s, const Data &data, Workspace &ctx)
 {
     int num_cus = data.customer_num;
     // find all unrouted customers
     // index points to the last position
     std::vector<int> record(num_cus + 1, 0);
-    find_unrouted(s, record);
+    find_unrouted(s, data, record);
 
     // first dim: node, second dim: position
     std::vector<std::tuple<int, int>> unrouted(data.customer_num);
@@ -847,42 +890,68 @@ void new_route_insertion(Solution &s, Data &data)
         }
     }
     if (index == 0) return;
-    if (data.ksize == 1)
+    if (ctx.ksize == 1)
     {
-        int selected = randint(0, index - 1, data.rng);
+        int selected = randint(0, index - 1, ctx.rng);
         int node = std::get<0>(unrouted[selected]);
-        new_route_insertion(s, data, node);
+        new_route_insertion(s, data, ctx, node);
     }  
     else
     {
-        double best_cost = double(INFINITY);
-        Solution best_s(data);
-        for (int i = 0; i < std::min(data.ksize, index); i++)
+        // draw the initial node and a rng seed of every start up front,
+        // such that the cheapest solution does not depend on the number of threads
+        int k = std::min(ctx.ksize, index);
+        std::vector<int> initial_nodes(k);
+        std::vector<unsigned int> seeds(k);
+        for (int i = 0; i < k; i++)
         {
-            int selected = randint(0, index-1-i, data.rng); 
-            int node = std::get<0>(unrouted[selected]);
+            int selected = randint(0, index-1-i, ctx.rng); 
+            initial_nodes[i] = std::get<0>(unrouted[selected]);
+            unrouted[selected] = unrouted[index-1-i];
+            seeds[i] = ctx.rng();
+        }
+        std::mt19937 rng = ctx.rng;
+        // worker 0 builds with ctx itself, the others with workspaces of their own.
+        // Each worker keeps its cheapest start, ties are broken by the start index
+        int n_workers = std::max(1, std::min(ctx.threads, k));
+        std::vector<Workspace> workers = ctx.fork(n_workers, 1, data);
+        std::vector<Solution> best_s(n_workers);
+        std::vector<int> best_start(n_workers, -1);
+        parallel_for(k, n_workers, [&](int i, int w) {
+            // past the deadline only the first start is built
+            Workspace &worker = (w == 0) ? ctx : workers[w - 1];
+            if (i > 0 && worker.deadline.expired()) return;
+            worker.rng.seed(seeds[i]);
             Solution tmp_s(data);
             tmp_s = s;
-            //printf("initial node: %d\n",node);
-            new_route_insertion(tmp_s, data, node);
-            if (tmp_s.cost - best_cost < -PRECISION)
+            //printf("initial node: %d\n",initial_nodes[i]);
+            new_route_insertion(tmp_s, data, worker, initial_nodes[i]);
+            if (best_start[w] == -1 || tmp_s.cost < best_s[w].cost || (tmp_s.cost == best_s[w].cost && i < best_start[w]))
             {
-                best_s = tmp_s;
-                best_cost = tmp_s.cost;
+                best_s[w] = tmp_s;
+                best_start[w] = i;
             }
-            unrouted[selected] = unrouted[index-1-i];
+        });
+        ctx.rng = rng;
+        // tasks are handed out dynamically, so a worker may have built no start at all
+        int best = -1;
+        for (int w = 0; w < n_workers; w++)
+        {
+            if (best_start[w] == -1) continue;
+            if (best == -1 || best_s[w].cost < best_s[best].cost || (best_s[w].cost == best_s[best].cost && best_start[w] < best_start[best]))
+                best = w;
         }
-        s = best_s;
+        s = best_s[best];
         s.update(data);
     }
 }
 
-void two_opt(int r1, int r2, Solution &s, Data &data, Move &m, double &base_cost)
+void two_opt(int r1, int r2, Solution &s, const Data &data, Workspace &ctx, Move &m, double &base_cost)
 {
     // inverse a 2-sequence in a route
     m.delta_cost = double(INFINITY);
 
-    Route &r = s.get(r1);
+    const Route &r = s.peek(r1);
     auto &n_l = r.node_list; // customer
     int len = int(n_l.size());
     if (len < 4) return;
@@ -898,31 +967,32 @@ void two_opt(int r1, int r2, Solution &s, Data &data, Move &m, double &base_cost
         if (r.gat(start+1, start).num_cus == INFEASIBLE)
            continue;
 
-        tmp_move.r_indice[0] = r1;
-        tmp_move.r_indice[1] = -2;  
-        tmp_move.len_1 = 3;
-        tmp_move.seqList_1[0] = {r1, 0, start-1};
-        tmp_move.seqList_1[1] = {r1, start+1, start};
-        tmp_move.seqList_1[2] = {r1, start+2, len-1};
-        tmp_move.len_2 = 0;
-        if (eval_move(s, tmp_move, data, base_cost) && tmp_move.delta_cost < m.delta_cost)
+        ctx.tmp_move.r_indice[0] = r1;
+        ctx.tmp_move.r_indice[1] = -2;  
+        ctx.tmp_move.len_1 = 3;
+        ctx.tmp_move.seqList_1[0] = {r1, 0, start-1};
+        ctx.tmp_move.seqList_1[1] = {r1, start+1, start};
+        ctx.tmp_move.seqList_1[2] = {r1, start+2, len-1};
+        ctx.tmp_move.len_2 = 0;
+        if (eval_move(s, ctx.tmp_move, data, ctx, base_cost) && ctx.tmp_move.delta_cost < m.delta_cost)
         {
-            m = tmp_move;
+            m = ctx.tmp_move;
         }
     }
 }
 
-void two_opt_star(int r1, int r2, Solution &s, Data &data, Move &m, double &base_cost)
+void two_opt_star(int r1, int r2, Solution &s, const Data &data, Workspace &ctx, Move &m, double &base_cost)
 {
     m.delta_cost = double(INFINITY);
 
-    Route &r_1 = s.get(r1);
+    const Route &r_1 = s.peek(r1);
     auto &n_l_1 = r_1.node_list;
     int len_1 = int(n_l_1.size());
 
-    Route &r_2 = s.get(r2);
+    const Route &r_2 = s.peek(r2);
     auto &n_l_2 = r_2.node_list;
     int len_2 = int(n_l_2.size());
+    long checked = 0, skipped = 0;
     for (int pos_1 = 1; pos_1 <= len_1 - 1; pos_1++)
     {
         for (int pos_2 = 1; pos_2 <= len_2 - 1; pos_2++)
@@ -933,26 +1003,34 @@ void two_opt_star(int r1, int r2, Solution &s, Data &data, Move &m, double &base
                 (!data.pm[n_l_1[pos_1-1]] [n_l_2[pos_2]] ||\
                     !data.pm[n_l_2[pos_2-1]][n_l_1[pos_1]]))
                     continue;
-            tmp_move.r_indice[0] = r1;
-            tmp_move.r_indice[1] = r2;
-            tmp_move.len_1 = 2;
-            tmp_move.seqList_1[0] = {r1, 0, pos_1-1};
-            tmp_move.seqList_1[1] = {r2, pos_2, len_2-1};
-            tmp_move.len_2 = 2;
-            tmp_move.seqList_2[0] = {r2, 0, pos_2-1};
-            tmp_move.seqList_2[1] = {r1, pos_1, len_1-1};
-            if (eval_move(s, tmp_move, data, base_cost) && tmp_move.delta_cost < m.delta_cost)
+            checked++;
+            if (!data.granular_arc(n_l_1[pos_1-1], n_l_2[pos_2]) &&
+                !data.granular_arc(n_l_2[pos_2-1], n_l_1[pos_1]))
             {
-                m = tmp_move;
+                skipped++;
+                continue;
+            }
+            ctx.tmp_move.r_indice[0] = r1;
+            ctx.tmp_move.r_indice[1] = r2;
+            ctx.tmp_move.len_1 = 2;
+            ctx.tmp_move.seqList_1[0] = {r1, 0, pos_1-1};
+            ctx.tmp_move.seqList_1[1] = {r2, pos_2, len_2-1};
+            ctx.tmp_move.len_2 = 2;
+            ctx.tmp_move.seqList_2[0] = {r2, 0, pos_2-1};
+            ctx.tmp_move.seqList_2[1] = {r1, pos_1, len_1-1};
+            if (eval_move(s, ctx.tmp_move, data, ctx, base_cost) && ctx.tmp_move.delta_cost < m.delta_cost)
+            {
+                m = ctx.tmp_move;
             }
         }
     }
+    count_granular(data, checked, skipped);
 }
 
-void or_opt_single(int r1, int r2, Solution &s, Data &data, Move &m, double &base_cost)
+void or_opt_single(int r1, int r2, Solution &s, const Data &data, Workspace &ctx, Move &m, double &base_cost)
 {
     m.delta_cost = double(INFINITY);
-    Route &r = s.get(r1);
+    const Route &r = s.peek(r1);
     auto &n_l = r.node_list;
     int len = int(n_l.size());
     if (len < 4) return;
@@ -972,17 +1050,17 @@ void or_opt_single(int r1, int r2, Solution &s, Data &data, Move &m, double &bas
                     (!data.pm[n_l[pos-1]][n_l[start]] ||\
                         !data.pm[n_l[end]][n_l[pos]]))
                         continue;
-                tmp_move.r_indice[0] = r1;
-                tmp_move.r_indice[1] = -2;
-                tmp_move.len_1 = 4;
-                tmp_move.seqList_1[0] = {r1, 0, pos-1};
-                tmp_move.seqList_1[1] = {r1, start, end};
-                tmp_move.seqList_1[2] = {r1, pos, start-1};
-                tmp_move.seqList_1[3] = {r1, end+1, len-1};
-                tmp_move.len_2 = 0;
-                if (eval_move(s, tmp_move, data, base_cost) && tmp_move.delta_cost < m.delta_cost)
+                ctx.tmp_move.r_indice[0] = r1;
+                ctx.tmp_move.r_indice[1] = -2;
+                ctx.tmp_move.len_1 = 4;
+                ctx.tmp_move.seqList_1[0] = {r1, 0, pos-1};
+                ctx.tmp_move.seqList_1[1] = {r1, start, end};
+                ctx.tmp_move.seqList_1[2] = {r1, pos, start-1};
+                ctx.tmp_move.seqList_1[3] = {r1, end+1, len-1};
+                ctx.tmp_move.len_2 = 0;
+                if (eval_move(s, ctx.tmp_move, data, ctx, base_cost) && ctx.tmp_move.delta_cost < m.delta_cost)
                 {
-                    m = tmp_move;
+                    m = ctx.tmp_move;
                 }
             }
             for (int pos = end + 2; pos <= len - 1; pos++)
@@ -991,40 +1069,41 @@ void or_opt_single(int r1, int r2, Solution &s, Data &data, Move &m, double &bas
                     (!data.pm[n_l[pos-1]][n_l[start]] ||
                         !data.pm[n_l[end]][n_l[pos]]))
                     continue;
-                tmp_move.r_indice[0] = r1;
-                tmp_move.r_indice[1] = -2;
-                tmp_move.len_1 = 4;
-                tmp_move.seqList_1[0] = {r1, 0, start-1};
-                tmp_move.seqList_1[1] = {r1, end+1, pos-1};
-                tmp_move.seqList_1[2] = {r1, start, end};
-                tmp_move.seqList_1[3] = {r1, pos, len-1};
-                tmp_move.len_2 = 0;
-                if (eval_move(s, tmp_move, data, base_cost) && tmp_move.delta_cost < m.delta_cost)
+                ctx.tmp_move.r_indice[0] = r1;
+                ctx.tmp_move.r_indice[1] = -2;
+                ctx.tmp_move.len_1 = 4;
+                ctx.tmp_move.seqList_1[0] = {r1, 0, start-1};
+                ctx.tmp_move.seqList_1[1] = {r1, end+1, pos-1};
+                ctx.tmp_move.seqList_1[2] = {r1, start, end};
+                ctx.tmp_move.seqList_1[3] = {r1, pos, len-1};
+                ctx.tmp_move.len_2 = 0;
+                if (eval_move(s, ctx.tmp_move, data, ctx, base_cost) && ctx.tmp_move.delta_cost < m.delta_cost)
                 {
-                    m = tmp_move;
+                    m = ctx.tmp_move;
                 }
             }
             // relocate to a new route
-            tmp_move.r_indice[0] = r1;
-            tmp_move.r_indice[1] = -1;
-            tmp_move.len_1 = 2;
-            tmp_move.seqList_1[0] = {r1, 0, start - 1};
-            tmp_move.seqList_1[1] = {r1, end + 1, len - 1};
-            tmp_move.len_2 = 3;
-            tmp_move.seqList_2[0] = {-1, data.DC, data.DC};
-            tmp_move.seqList_2[1] = {r1, start, end};
-            tmp_move.seqList_2[2] = {-1, data.DC, data.DC};
-            if (eval_move(s, tmp_move, data, base_cost) && tmp_move.delta_cost < m.delta_cost)
+            ctx.tmp_move.r_indice[0] = r1;
+            ctx.tmp_move.r_indice[1] = -1;
+            ctx.tmp_move.len_1 = 2;
+            ctx.tmp_move.seqList_1[0] = {r1, 0, start - 1};
+            ctx.tmp_move.seqList_1[1] = {r1, end + 1, len - 1};
+            ctx.tmp_move.len_2 = 3;
+            ctx.tmp_move.seqList_2[0] = {-1, data.DC, data.DC};
+            ctx.tmp_move.seqList_2[1] = {r1, start, end};
+            ctx.tmp_move.seqList_2[2] = {-1, data.DC, data.DC};
+            if (eval_move(s, ctx.tmp_move, data, ctx, base_cost) && ctx.tmp_move.delta_cost < m.delta_cost)
             {
-                m = tmp_move;
+                m = ctx.tmp_move;
             }
         }
     }
 }
 
-void or_opt_double(int r_index_1, int r_index_2, Solution &s, Data &data, Move &m, double &base_cost)
+void or_opt_double(int r_index_1, int r_index_2, Solution &s, const Data &data, Workspace &ctx, Move &m, double &base_cost)
 {
     m.delta_cost = double(INFINITY);
+    long checked = 0, skipped = 0;
     // relocate a sequence
     for (int i = 0; i < 2; i++)
     {
@@ -1039,7 +1118,7 @@ void or_opt_double(int r_index_1, int r_index_2, Solution &s, Data &data, Move &
             r1 = r_index_2;
             r2 = r_index_1;
         }
-        Route &r = s.get(r1);
+        const Route &r = s.peek(r1);
         auto &n_l = r.node_list;
         int len = int(n_l.size());
         for (int start = 1; start <= len - 2; start++)
@@ -1056,7 +1135,7 @@ void or_opt_double(int r_index_1, int r_index_2, Solution &s, Data &data, Move &
 
                 if (r1 == r2)
                     continue;
-                Route &r_2 = s.get(r2);
+                const Route &r_2 = s.peek(r2);
                 auto &n_l_2 = r_2.node_list;
                 int len_2 = int(n_l_2.size());
                 for (int pos = 1; pos <= len_2 - 1; pos++)
@@ -1065,36 +1144,45 @@ void or_opt_double(int r_index_1, int r_index_2, Solution &s, Data &data, Move &
                         (!data.pm[n_l_2[pos - 1]][n_l[start]] ||
                          !data.pm[n_l[end]][n_l_2[pos]]))
                         continue;
-                    tmp_move.r_indice[0] = r1;
-                    tmp_move.r_indice[1] = r2;
-                    tmp_move.len_1 = 2;
-                    tmp_move.seqList_1[0] = {r1, 0, start - 1};
-                    tmp_move.seqList_1[1] = {r1, end + 1, len - 1};
-                    tmp_move.len_2 = 3;
-                    tmp_move.seqList_2[0] = {r2, 0, pos - 1};
-                    tmp_move.seqList_2[1] = {r1, start, end};
-                    tmp_move.seqList_2[2] = {r2, pos, len_2 - 1};
-                    if (eval_move(s, tmp_move, data, base_cost) && tmp_move.delta_cost < m.delta_cost)
+                    checked++;
+                    if (!data.granular_arc(n_l_2[pos - 1], n_l[start]) &&
+                        !data.granular_arc(n_l[end], n_l_2[pos]))
                     {
-                        m = tmp_move;
+                        skipped++;
+                        continue;
+                    }
+                    ctx.tmp_move.r_indice[0] = r1;
+                    ctx.tmp_move.r_indice[1] = r2;
+                    ctx.tmp_move.len_1 = 2;
+                    ctx.tmp_move.seqList_1[0] = {r1, 0, start - 1};
+                    ctx.tmp_move.seqList_1[1] = {r1, end + 1, len - 1};
+                    ctx.tmp_move.len_2 = 3;
+                    ctx.tmp_move.seqList_2[0] = {r2, 0, pos - 1};
+                    ctx.tmp_move.seqList_2[1] = {r1, start, end};
+                    ctx.tmp_move.seqList_2[2] = {r2, pos, len_2 - 1};
+                    if (eval_move(s, ctx.tmp_move, data, ctx, base_cost) && ctx.tmp_move.delta_cost < m.delta_cost)
+                    {
+                        m = ctx.tmp_move;
                     }
                 }
             }
         }
     }
+    count_granular(data, checked, skipped);
 }
 
-void two_exchange(int r1, int r2, Solution &s, Data &data, Move &m, double &base_cost)
+void two_exchange(int r1, int r2, Solution &s, const Data &data, Workspace &ctx, Move &m, double &base_cost)
 {
     m.delta_cost = double(INFINITY);
     // exchange two sequences with seqs
-    Route &r_1 = s.get(r1);
+    const Route &r_1 = s.peek(r1);
     auto &n_l_1 = r_1.node_list;
     int len_1 = int(n_l_1.size());
 
-    Route &r_2 = s.get(r2);
+    const Route &r_2 = s.peek(r2);
     auto &n_l_2 = r_2.node_list;
     int len_2 = int(n_l_2.size());
+    long checked = 0, skipped = 0;
     for (int start_1 = 1; start_1 <= len_1 - 2; start_1++)
     {
         for (int seq_len_1 = 1; seq_len_1 <= data.exchange_len; seq_len_1++)
@@ -1113,69 +1201,59 @@ void two_exchange(int r1, int r2, Solution &s, Data &data, Move &m, double &base
                             !data.pm[n_l_2[start_2-1]][n_l_1[start_1]] ||\
                             !data.pm[n_l_1[end_1]][n_l_2[end_2+1]]))
                         continue;
-                    tmp_move.r_indice[0] = r1;
-                    tmp_move.r_indice[1] = r2;
-                    tmp_move.len_1 = 3;
-                    tmp_move.seqList_1[0] = {r1, 0, start_1-1};
-                    tmp_move.seqList_1[1] = {r2, start_2, end_2};
-                    tmp_move.seqList_1[2] = {r1, end_1+1, len_1-1};
-                    tmp_move.len_2 = 3;
-                    tmp_move.seqList_2[0] = {r2, 0, start_2-1};
-                    tmp_move.seqList_2[1] = {r1, start_1, end_1};
-                    tmp_move.seqList_2[2] = {r2, end_2+1, len_2-1};
-                    if (eval_move(s, tmp_move, data, base_cost) && tmp_move.delta_cost < m.delta_cost)
+                    checked++;
+                    if (!data.granular_arc(n_l_1[start_1-1], n_l_2[start_2]) &&
+                        !data.granular_arc(n_l_2[end_2], n_l_1[end_1+1]) &&
+                        !data.granular_arc(n_l_2[start_2-1], n_l_1[start_1]) &&
+                        !data.granular_arc(n_l_1[end_1], n_l_2[end_2+1]))
                     {
-                        m = tmp_move;
+                        skipped++;
+                        continue;
+                    }
+                    ctx.tmp_move.r_indice[0] = r1;
+                    ctx.tmp_move.r_indice[1] = r2;
+                    ctx.tmp_move.len_1 = 3;
+                    ctx.tmp_move.seqList_1[0] = {r1, 0, start_1-1};
+                    ctx.tmp_move.seqList_1[1] = {r2, start_2, end_2};
+                    ctx.tmp_move.seqList_1[2] = {r1, end_1+1, len_1-1};
+                    ctx.tmp_move.len_2 = 3;
+                    ctx.tmp_move.seqList_2[0] = {r2, 0, start_2-1};
+                    ctx.tmp_move.seqList_2[1] = {r1, start_1, end_1};
+                    ctx.tmp_move.seqList_2[2] = {r2, end_2+1, len_2-1};
+                    if (eval_move(s, ctx.tmp_move, data, ctx, base_cost) && ctx.tmp_move.delta_cost < m.delta_cost)
+                    {
+                        m = ctx.tmp_move;
                     }
                 }
             }
         }
     }
+    count_granular(data, checked, skipped);
 }
 
-void removal_from_s(Solution &s, std::vector<int>& flag)
+void removal_from_s(Solution &s, const Data &data, std::vector<int>& flag)
 {
-    int s_len = s.len();
-    for (int r_index = 0; r_index < s_len; r_index++)
+    // one stable compaction per route serving a flagged customer, only those routes are updated
+    std::vector<int> routes = routes_of(s, data, flag);
+    for (int r_index : routes)
     {
-        Route &r = s.get(r_index);
-        auto &n_l = r.node_list;
-        int len = int(n_l.size());
-        for (int i = 0; i < len; i++)
-        {
-            if (flag[n_l[i]] == 1)
-            {
-                n_l.erase(n_l.begin() + i);
-                i--;
-                len--;
-            }
-        }
+        auto &n_l = s.get(r_index).node_list;
+        n_l.erase(std::remove_if(n_l.begin(), n_l.end(),
+                [&data, &flag](int node) { return data.node[node].type == 1 && flag[node] == 1; }), n_l.end());
     }
+    s.update(data, routes);
 }
 
-void removal_from_s(Solution &s, Data &data, std::vector<int>& flag)
+void removal_from_s(Solution &s, const Data &data, SearchContext &ctx, std::vector<int>& flag)
 {
-    int s_len = s.len();
-    for (int r_index = 0; r_index < s_len; r_index++)
-    {
-        Route &r = s.get(r_index);
-        auto &n_l = r.node_list;
-        int len = int(n_l.size());
-        for (int i = 0; i < len; i++)
-        {
-
-            if (data.node[n_l[i]].type == 1 && flag[n_l[i]] == 1)
-            {
-                n_l.erase(n_l.begin() + i);
-                i--;
-                len--;
-            }
-        }
-    }
-    for (int r_index = 0; r_index < s_len; r_index++)
+    // as above, and the stations of the changed routes are inserted again
+    std::vector<int> routes = routes_of(s, data, flag);
+    for (int r_index : routes)
     {
         Route &r = s.get(r_index);
         auto &n_l = r.node_list;
+        n_l.erase(std::remove_if(n_l.begin(), n_l.end(),
+                [&data, &flag](int node) { return data.node[node].type == 1 && flag[node] == 1; }), n_l.end());
         r.customer_list.clear();
         int len = int(n_l.size());
         for (int i = 0; i < len; i++)
@@ -1191,7 +1269,7 @@ void removal_from_s(Solution &s, Data &data, std::vector<int>& flag)
         update_route_status(r.temp_node_list,r.status_list,data,f,new_cost,index_negtive_first); 
         std::vector<std::pair<int,int>> station_insert_pos;
         station_insert_pos.clear();
-        if (f == 4 && sequential_station_insertion(f, index_negtive_first, r, data, station_insert_pos, new_cost)){
+        if (f == 4 && sequential_station_insertion(f, index_negtive_first, r, data, ctx, station_insert_pos, new_cost)){
             for (int i=0; i<station_insert_pos.size(); i++){
                 r.customer_list.insert(r.customer_list.begin()+ station_insert_pos[i].second, station_insert_pos[i].first); 
                
@@ -1200,44 +1278,57 @@ void removal_from_s(Solution &s, Data &data, std::vector<int>& flag)
         }
 
     }
-
-
+    s.update(data, routes);
 }
 
-void related_removal(Solution &s, Data &data)
+void related_removal(Solution &s, const Data &data, SearchContext &ctx)
 {
-    int selected = randint(0, data.customer_num, data.rng);
+    int selected = randint(0, data.customer_num, ctx.rng);
     while(selected == data.DC)
-        selected = randint(0, data.customer_num, data.rng);
+        selected = randint(0, data.customer_num, ctx.rng);
     std::vector<int> flag(data.customer_num+1, 0);
     std::vector<int> selected_cus;
     selected_cus.reserve(data.customer_num);
     flag[selected] = 1;
     selected_cus.push_back(selected);
     int total_remove = round(data.customer_num * \
-                             rand(data.destroy_ratio_l, data.destroy_ratio_u, data.rng));
+                             rand(ctx.destroy_ratio_l, ctx.destroy_ratio_u, ctx.rng));
     int already_remove = 1;
     while (already_remove < total_remove)
     {
-        int ref_cus = selected_cus[randint(0, int(selected_cus.size())-1, data.rng)];
+        int ref_cus = selected_cus[randint(0, int(selected_cus.size())-1, ctx.rng)];
         auto &argrank = data.rm_argrank[ref_cus];
         std::vector<int> best_two;
         best_two.reserve(2);
-        for (int i = 0; i < data.customer_num - 1; i++)
+        for (int c : argrank)
         {
-            if (flag[argrank[i]] == 1) continue;
-            best_two.push_back(argrank[i]);
+            if (flag[c] == 1) continue;
+            best_two.push_back(c);
             if (int(best_two.size())== 2) break;
         }
         if (int(best_two.size()) != 2)
         {
-            printf("Cound not find not 2 inserted customers in related removal\n");
-            exit(-1);
+            // all customers ranked for ref_cus but one are removed, rank the remaining ones
+            std::vector<std::pair<double, int>> remaining;
+            for (int c = 0; c <= data.customer_num; c++)
+            {
+                if (c == data.DC || c == ref_cus || flag[c] == 1) continue;
+                remaining.push_back(std::make_pair(data.relatedness(ref_cus, c, data.r), c));
+            }
+            if (int(remaining.size()) < 2)
+            {
+                printf("Cound not find not 2 inserted customers in related removal\n");
+                exit(-1);
+            }
+            std::partial_sort(remaining.begin(), remaining.begin() + 2, remaining.end());
+            best_two = {remaining[0].second, remaining[1].second};
         }
         // roulette selection
         int selected = -1;
-        double prob = data.rm[ref_cus][best_two[1]] / (data.rm[ref_cus][best_two[0]] + data.rm[ref_cus][best_two[1]]);
-        if (rand(0, 1, data.rng) < prob)
+        double rm_0 = data.relatedness(ref_cus, best_two[0], data.r);
+        double rm_1 = data.relatedness(ref_cus, best_two[1], data.r);
+        double prob = rm_1 / (rm_0 + rm_1);
+        if (rand(0, 1, ctx.rng) < prob)
             selected = best_two[0];
         else
             selected = best_two[1];
@@ -1245,13 +1336,12 @@ void related_removal(Solution &s, Data &data)
         selected_cus.push_back(selected);
         already_remove ++;
     }
-    removal_from_s(s, data, flag);
-    s.update(data);
+    removal_from_s(s, data, ctx, flag);
     // s.cal_cost(data);
     // s.output(data);
 }
 
-void random_removal(Solution &s, Data &data)
+void random_removal(Solution &s, const Data &data, SearchContext &ctx)
 {
     // randomly delete customers from s
     std::vector<int> customers(data.customer_num);
@@ -1263,12 +1353,11 @@ void random_removal(Solution &s, Data &data)
         customers[count] = i;
         count++;
     }
-    shuffle(customers.begin(), customers.end(), data.rng);
+    shuffle(customers.begin(), customers.end(), ctx.rng);
     int boundray = int(round(double(data.customer_num) *\
-                       rand(data.destroy_ratio_l, data.destroy_ratio_u, data.rng)));
+                       rand(ctx.destroy_ratio_l, ctx.destroy_ratio_u, ctx.rng)));
     for (int i = 0; i < boundray + 1; i++) {indice[customers[i]] = 1;}
-    removal_from_s(s, indice);
-    s.update(data);
+    removal_from_s(s, data, indice);
 }
 
 void output_move(Move &m)
@@ -1286,60 +1375,257 @@ void output_move(Move &m)
     }
 }
 
-void snippet(int r1, int r2, std::string &opt, Solution &s, Data &data, Move &target, double &base_cost)
+void route_pairs(SmallOpt opt, int len, const std::vector<int> &touched, std::vector<std::pair<int, int>> &pairs)
+{
+    // sub-neighborhoods of opt, i.e., routes (r, -1) or route pairs (r1, r2) with r1 < r2.
+    // If touched is not empty, only those involving a touched route are listed, each once
+    pairs.clear();
+    bool all = touched.empty();
+    std::vector<bool> in_touched(len, all);
+    for (auto &r : touched)
+    {
+        if (r < len) in_touched[r] = true;
+    }
+    if (!SMALL_OPT_ROUTE_PAIRS[opt])
+    {
+        for (int r = 0; r < len; r++)
+        {
+            if (in_touched[r]) pairs.push_back(std::make_pair(r, -1));
+        }
+    }
+    else
+    {
+        for (int r1 = 0; r1 < len; r1++)
+        {
+            for (int r2 = r1 + 1; r2 < len; r2++)
+            {
+                if (in_touched[r1] || in_touched[r2]) pairs.push_back(std::make_pair(r1, r2));
+            }
+        }
+    }
+}
+
+typedef void (*SmallOptFn)(int, int, Solution &, const Data &, Workspace &, Move &, double &);
+
+// the scan is instantiated per opt, such that the opt is called directly and may be inlined
+template <SmallOptFn small_opt>
+void scan_route_pairs(SmallOpt opt, std::vector<std::pair<int, int>> &pairs, Solution &s, const Data &data, SearchContext &ctx,
+                      std::vector<Workspace> &workers, Move &target, double &base_cost)
+{
+    // find the best move of opt in each sub-neighborhood in pairs, spread across the worker threads.
+    // Each sub-neighborhood owns its memo slot and rng stream, and target is reduced in the order of pairs
+    int n = int(pairs.size());
+    std::vector<Move *> slots(n);
+    std::vector<unsigned int> seeds(n);
+    for (int k = 0; k < n; k++)
+    {
+        slots[k] = &ctx.get_mem(opt, pairs[k].first, pairs[k].second);
+        seeds[k] = ctx.rng();
+    }
+    std::mt19937 rng = ctx.rng;
+    // worker 0 evaluates with ctx itself, the others with workspaces of their own
+    int n_workers = std::max(1, std::min(ctx.threads, n));
+    if (int(workers.size()) < n_workers - 1) workers = ctx.fork(n_workers, 1, data);
+    parallel_for(n, n_workers, [&](int k, int w) {
+        Workspace &worker = (w == 0) ? ctx : workers[w - 1];
+        // only PSSI in CLS draws from the rng, few sub-neighborhoods get there
+        worker.defer_seed(seeds[k]);
+        // past the deadline the slots keep their old moves, find_local_optima stops before applying one
+        if (worker.deadline.expired()) return;
+        small_opt(pairs[k].first, pairs[k].second, s, data, worker, *slots[k], base_cost);
+    });
+    ctx.rng = rng;
+    ctx.seed_deferred = false;
+    for (int k = 0; k < n; k++)
+    {
+        if (slots[k]->delta_cost - target.delta_cost < -PRECISION)
+            target = *slots[k];
+    }
+}
+
+// distance of the bounding boxes of two routes
+static double space_gap(const Route &r1, const Route &r2)
+{
+    double dx = std::max(std::max(r1.min_x - r2.max_x, r2.min_x - r1.max_x), 0.0);
+    double dy = std::max(std::max(r1.min_y - r2.max_y, r2.min_y - r1.max_y), 0.0);
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+// distance of the time-window spans of two routes
+static double time_gap(const Route &r1, const Route &r2)
+{
+    return std::max(std::max(r1.tw_start - r2.tw_end, r2.tw_start - r1.tw_end), 0.0);
+}
+
+// the q-quantile of the first n values of v
+static double quantile(const double *v, int n, double q)
+{
+    std::vector<double> sorted(v, v + n);
+    int k = std::min(int(q * n), n - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+    return sorted[k];
+}
+
+// a find_local_optima call starts, after the warm-up it skips route pairs but in exploring calls
+static void start_proximity(const Data &data, SearchContext &ctx)
+{
+    RouteProximity &p = ctx.proximity;
+    p.filtering = data.route_proximity && p.gaps > 0 && p.calls >= PROXIMITY_WARMUP && p.calls % PROXIMITY_EXPLORE != 0;
+    p.calls++;
+    if (!p.filtering) return;
+    int n = int(std::min(p.gaps, long(PROXIMITY_MEMORY)));
+    p.max_space = PROXIMITY_SLACK * quantile(p.space_gap, n, PROXIMITY_QUANTILE);
+    p.max_time = PROXIMITY_SLACK * quantile(p.time_gap, n, PROXIMITY_QUANTILE);
+}
+
+// drop the route pairs further apart than the learned radius, their memo slots are cleared
+static void filter_route_pairs(SmallOpt opt, std::vector<std::pair<int, int>> &pairs, Solution &s, SearchContext &ctx)
+{
+    if (!SMALL_OPT_ROUTE_PAIRS[opt]) return;
+    int n = int(pairs.size()), kept = 0;
+    if (ctx.proximity.filtering)
+    {
+        for (int k = 0; k < n; k++)
+        {
+            const Route &r1 = s.peek(pairs[k].first);
+            const Route &r2 = s.peek(pairs[k].second);
+            if (!r1.isempty() && !r2.isempty() &&
+                (space_gap(r1, r2) > ctx.proximity.max_space || time_gap(r1, r2) > ctx.proximity.max_time))
+            {
+                ctx.get_mem(opt, pairs[k].first, pairs[k].second).delta_cost = double(INFINITY);
+                if (!ctx.mem_key[opt].empty()) ctx.get_mem_key(opt, pairs[k].first, pairs[k].second) = 0;
+                continue;
+            }
+            pairs[kept++] = pairs[k];
+        }
+        pairs.resize(kept);
+    }
+    else kept = n;
+    proximity_checked.fetch_add(n, std::memory_order_relaxed);
+    proximity_skipped.fetch_add(n - kept, std::memory_order_relaxed);
+}
+
+// sample the gaps of the route pairs now holding an improving move, unless pairs were skipped
+static void learn_route_gaps(SmallOpt opt, const std::vector<std::pair<int, int>> &pairs, Solution &s, SearchContext &ctx)
+{
+    RouteProximity &p = ctx.proximity;
+    if (!SMALL_OPT_ROUTE_PAIRS[opt] || p.filtering) return;
+    for (auto &pair : pairs)
+    {
+        if (!(ctx.get_mem(opt, pair.first, pair.second).delta_cost < -PRECISION)) continue;
+        const Route &r1 = s.peek(pair.first);
+        const Route &r2 = s.peek(pair.second);
+        if (r1.isempty() || r2.isempty()) continue;
+        int slot = int(p.gaps % PROXIMITY_MEMORY);
+        p.space_gap[slot] = space_gap(r1, r2);
+        p.time_gap[slot] = time_gap(r1, r2);
+        p.gaps++;
+    }
+}
+
+// what the best move of a route depends on: its node list in ALS (base_cost == -1), in CLS also
+// its stationed node list and cost
+static unsigned long long route_key(const Route &r, double base_cost)
+{
+    if (base_cost == -1) return hash_nodes(r.node_list);
+    unsigned long long cost;
+    memcpy(&cost, &r.total_cost, sizeof(cost));
+    return (hash_nodes(r.customer_list, hash_nodes(r.node_list)) ^ cost) * 1099511628211ULL;
+}
+
+// key of the memo slot of (r1, r2), never 0
+static unsigned long long slot_key(const std::vector<unsigned long long> &keys, int r1, int r2)
+{
+    unsigned long long h = keys[r1];
+    h = (h ^ (h >> 29)) * 1099511628211ULL;
+    if (r2 >= 0) h ^= keys[r2];
+    h = (h ^ (h >> 29)) * 1099511628211ULL;
+    return h | 1;
+}
+
+// drop the sub-neighborhoods found to hold no improving move on their current routes, in this
+// call or an earlier one. Their slots may have been overwritten since, they are cleared
+static void drop_clean_pairs(SmallOpt opt, std::vector<std::pair<int, int>> &pairs, const std::vector<unsigned long long> &keys, SearchContext &ctx)
+{
+    int n = int(pairs.size()), kept = 0;
+    for (int k = 0; k < n; k++)
+    {
+        if (ctx.get_mem_key(opt, pairs[k].first, pairs[k].second) == slot_key(keys, pairs[k].first, pairs[k].second))
+        {
+            ctx.get_mem(opt, pairs[k].first, pairs[k].second).delta_cost = double(INFINITY);
+            continue;
+        }
+        pairs[kept++] = pairs[k];
+    }
+    pairs.resize(kept);
+    memo_listed.fetch_add(n, std::memory_order_relaxed);
+    memo_reused.fetch_add(n - kept, std::memory_order_relaxed);
+}
+
+// registration of the small step-size opts, one case per SmallOpt
+void scan_route_pairs(SmallOpt opt, std::vector<std::pair<int, int>> &pairs, Solution &s, const Data &data, SearchContext &ctx,
+                      std::vector<Workspace> &workers, Move &target, double &base_cost)
 {
-    auto &m = data.get_mem(opt, r1, r2);
-    small_opt_map[opt](r1, r2, s, data, m, base_cost);
-    if (m.delta_cost - target.delta_cost < -PRECISION)
-        target = m;
+    std::vector<unsigned long long> keys;
+    if (data.dirty_routes)
+    {
+        for (int r = 0; r < s.len(); r++) keys.push_back(route_key(s.peek(r), base_cost));
+        drop_clean_pairs(opt, pairs, keys, ctx);
+    }
+    if (data.route_proximity) filter_route_pairs(opt, pairs, s, ctx);
+    switch (opt)
+    {
+    case TWO_OPT: scan_route_pairs<two_opt>(opt, pairs, s, data, ctx, workers, target, base_cost); break;
+    case TWO_OPT_STAR: scan_route_pairs<two_opt_star>(opt, pairs, s, data, ctx, workers, target, base_cost); break;
+    case OR_OPT_SINGLE: scan_route_pairs<or_opt_single>(opt, pairs, s, data, ctx, workers, target, base_cost); break;
+    case OR_OPT_DOUBLE: scan_route_pairs<or_opt_double>(opt, pairs, s, data, ctx, workers, target, base_cost); break;
+    case TWO_EXCHANGE: scan_route_pairs<two_exchange>(opt, pairs, s, data, ctx, workers, target, base_cost); break;
+    default:
+        printf("Unknown opt: %d\n", int(opt));
+        exit(-1);
+    }
+    if (data.dirty_routes)
+    {
+        // past the deadline some slots were not evaluated
+        bool expired = ctx.deadline.expired();
+        for (auto &pair : pairs)
+        {
+            bool improving = ctx.get_mem(opt, pair.first, pair.second).delta_cost < -PRECISION;
+            ctx.get_mem_key(opt, pair.first, pair.second) = (expired || improving) ? 0 : slot_key(keys, pair.first, pair.second);
+        }
+    }
+    if (data.route_proximity) learn_route_gaps(opt, pairs, s, ctx);
 }
 
-void find_local_optima(Solution &s, Data &data, Solution &s_N)
+void find_local_optima(Solution &s, const Data &data, SearchContext &ctx, Solution &s_N)
 {   
     // delta_value: VRP-TW-SPD  
     double base_cost = -1; // means do not use base_cost
 
     if (data.skip_finding_lo) return;
+    start_proximity(data, ctx);
     // record the best solution in the neighborhood of each small opt
     std::vector<Move> move_list(int(data.small_opts.size()));
 
     // find the best move for all sub-neighbors of each opt
+    std::vector<std::pair<int, int>> pairs;
+    std::vector<Workspace> workers; // scratch for the worker threads, created on first use
     int len = int(s.len());
     for (int i = 0; i < int(move_list.size()); i++)
     {
         move_list[i].delta_cost = double(INFINITY);
-        auto &opt = data.small_opts[i];
+        SmallOpt opt = data.small_opts[i];
         
         // std::cout<<opt<<std::endl;
         
-        if (opt == "2opt" || opt == "oropt_single")
-        {
-            for (int r = 0; r < len; r++)
-            {
-                snippet(r, -1, opt, s, data, move_list[i], base_cost);
-            }
-        }
-        else if (opt == "2opt*" || opt == "2exchange" || opt == "oropt_double")
-        {
-            for (int r1 = 0; r1 < len; r1++)
-            {
-                for (int r2 = r1 + 1; r2 < len; r2++)
-                {
-                    snippet(r1, r2, opt, s, data, move_list[i], base_cost);
-                }
-            }
-        }
-        else
-        {
-            std::cout << "Unknown opt: " << opt;
-            exit(-1);
-        }
+        route_pairs(opt, len, std::vector<int>(), pairs);
+        scan_route_pairs(opt, pairs, s, data, ctx, workers, move_list[i], base_cost);
     }
 
     // double acc_delta_cost = 0;
     std::vector<int> tour_id_array;
     //std::vector<int> no_use;
-    while (true)
+    while (!ctx.deadline.expired())
     {
         int best_index = -1;
         double min_delta_cost = double(INFINITY);
@@ -1368,8 +1654,8 @@ void find_local_optima(Solution &s, Data &data, Solution &s_N)
             
             */
             tour_id_array = apply_move(item, move_list[best_index], data); 
-            double ori_cost = s.get(move_list[best_index].r_indice[0]).total_cost;
-            if (move_list[best_index].r_indice[1] >= 0) ori_cost += s.get(move_list[best_index].r_indice[1]).total_cost;
+            double ori_cost = s.peek(move_list[best_index].r_indice[0]).total_cost;
+            if (move_list[best_index].r_indice[1] >= 0) ori_cost += s.peek(move_list[best_index].r_indice[1]).total_cost;
             double new_cost = 0.0;
             /*
 
@@ -1378,10 +1664,10 @@ void find_local_optima(Solution &s, Data &data, Solution &s_N)
             */
             for (auto j: tour_id_array) {
                     if (j >= item.len()) {
-                        if (move_list[best_index].r_indice[0] < item.len() && move_list[best_index].r_indice[1] < item.len()) ori_cost += s.get(j).total_cost;
+                        if (move_list[best_index].r_indice[0] < item.len() && move_list[best_index].r_indice[1] < item.len()) ori_cost += s.peek(j).total_cost;
                         continue;
                     }
-                    Route r= item.get(j);
+                    Route r= item.peek(j);
                     std::swap(r.node_list, r.customer_list);
                     r.temp_node_list = r.customer_list;
                     int flag = 0;
@@ -1390,9 +1676,9 @@ void find_local_optima(Solution &s, Data &data, Solution &s_N)
                     update_route_status(r.temp_node_list,r.status_list,data,flag,cost,index_negtive_first); 
                     if (flag == 0 || flag == 2 || flag == 3) return;
                     if (flag == 1) { item.get(j).total_cost = item.get(j).cal_cost(data); }
-                    if (flag == 4 && ! parallel_sequential_station_insertion(item, r, data, j)) return;
+                    if (flag == 4 && ! parallel_sequential_station_insertion(item, r, data, ctx, j)) return;
                     // If this transformation is not possible, then ALS would terminate
-                    new_cost += item.get(j).total_cost;
+                    new_cost += item.peek(j).total_cost;
             } 
 
             for (auto j: tour_id_array) {
@@ -1420,50 +1706,19 @@ void find_local_optima(Solution &s, Data &data, Solution &s_N)
             for (int i = 0; i < int(move_list.size()); i++)
             {
                 move_list[i].delta_cost = double(INFINITY);
-                auto &opt = data.small_opts[i];
+                SmallOpt opt = data.small_opts[i];
 
                 //std::cout<<opt<<std::endl;
 
-                if (opt == "2opt" || opt == "oropt_single")
-                {
-                    for (auto &r : tour_id_array)
-                    {
-                        if (r >= len) continue;
-                        snippet(r, -1, opt, s, data, move_list[i], base_cost);
-                    }
-                    for (int r = 0; r < len; r++)
-                    {
-                        if (data.get_mem(opt, r, -1).delta_cost - move_list[i].delta_cost < -PRECISION)
-                            move_list[i] = data.get_mem(opt, r, -1);
-                    }
-                }
-                else if (opt == "2opt*" || opt == "2exchange" || opt == "oropt_double")
-                {
-                    for (auto &r : tour_id_array)
-                    {
-                        if (r >= len) continue;
-                        for (int r1 = 0; r1 < r; r1++)
-                        {
-                            snippet(r1, r, opt, s, data, move_list[i], base_cost);
-                        }
-                        for (int r1 = r+1; r1 < len; r1++)
-                        {
-                            snippet(r, r1, opt, s, data, move_list[i], base_cost);
-                        }
-                    }
-                    for (int r1 = 0; r1 < len; r1++)
-                    {
-                        for (int r2 = r1 + 1; r2 < len; r2++)
-                        {
-                            if (data.get_mem(opt, r1, r2).delta_cost - move_list[i].delta_cost < -PRECISION)
-                                move_list[i] = data.get_mem(opt, r1, r2);
-                        }
-                    }
-                }
-                else
+                // re-evaluate the sub-neighborhoods of changed routes, then take the best over the memo
+                route_pairs(opt, len, tour_id_array, pairs);
+                scan_route_pairs(opt, pairs, s, data, ctx, workers, move_list[i], base_cost);
+                route_pairs(opt, len, std::vector<int>(), pairs);
+                for (auto &pair : pairs)
                 {
-                    std::cout << "Unknown opt: " << opt;
-                    exit(-1);
+                    Move &m = ctx.get_mem(opt, pair.first, pair.second);
+                    if (m.delta_cost - move_list[i].delta_cost < -PRECISION)
+                        move_list[i] = m;
                 }
             }
         }
@@ -1472,51 +1727,34 @@ void find_local_optima(Solution &s, Data &data, Solution &s_N)
     }
 }
 
-void find_local_optima(Solution &s, Data &data, double base_cost)
+void find_local_optima(Solution &s, const Data &data, SearchContext &ctx, double base_cost)
 {
     // delta_value: EVRP-TW-SPD
 
     if (data.skip_finding_lo) return;
+    start_proximity(data, ctx);
     // record the best solution in the neighborhood of each small opt
     std::vector<Move> move_list(int(data.small_opts.size()));
 
     // find the best move for all sub-neighbors of each opt
+    std::vector<std::pair<int, int>> pairs;
+    std::vector<Workspace> workers; // scratch for the worker threads, created on first use
     int len = int(s.len());
     for (int i = 0; i < int(move_list.size()); i++)
     {
         move_list[i].delta_cost = double(INFINITY);
-        auto &opt = data.small_opts[i];
+        SmallOpt opt = data.small_opts[i];
         
         //std::cout<<opt<<std::endl;
         
-        if (opt == "2opt" || opt == "oropt_single")
-        {
-            for (int r = 0; r < len; r++)
-            {
-                snippet(r, -1, opt, s, data, move_list[i], base_cost);
-            }
-        }
-        else if (opt == "2opt*" || opt == "2exchange" || opt == "oropt_double")
-        {
-            for (int r1 = 0; r1 < len; r1++)
-            {
-                for (int r2 = r1 + 1; r2 < len; r2++)
-                {
-                    snippet(r1, r2, opt, s, data, move_list[i], base_cost);
-                }
-            }
-        }
-        else
-        {
-            std::cout << "Unknown opt: " << opt;
-            exit(-1);
-        }
+        route_pairs(opt, len, std::vector<int>(), pairs);
+        scan_route_pairs(opt, pairs, s, data, ctx, workers, move_list[i], base_cost);
     }
 
     // double acc_delta_cost = 0;
     std::vector<int> tour_id_array;
     //std::vector<int> no_use;
-    while (true)
+    while (!ctx.deadline.expired())
     {
         int best_index = -1;
         double min_delta_cost = double(INFINITY);
@@ -1551,7 +1789,7 @@ void find_local_optima(Solution &s, Data &data, double base_cost)
                 for (int k = 0; k < 2; k++){  
                     if (set.find(k) == set.end()) continue; 
                     // if (std::find(move_list[best_index].list[k].begin(), move_list[best_index].list[k].end(), s.get(tour_id_array[j]).node_list[1]) != move_list[best_index].list[k].end())
-                    if (iscustomerlist(s.get(tour_id_array[j]).node_list, move_list[best_index].list[k]))
+                    if (iscustomerlist(s.peek(tour_id_array[j]).node_list, move_list[best_index].list[k]))
                     {
                         set.erase(k);
                         s.get(tour_id_array[j]).customer_list = move_list[best_index].list[k];
@@ -1570,50 +1808,19 @@ void find_local_optima(Solution &s, Data &data, double base_cost)
             for (int i = 0; i < int(move_list.size()); i++)
             {
                 move_list[i].delta_cost = double(INFINITY);
-                auto &opt = data.small_opts[i];
+                SmallOpt opt = data.small_opts[i];
 
                 //std::cout<<opt<<std::endl;
 
-                if (opt == "2opt" || opt == "oropt_single")
-                {
-                    for (auto &r : tour_id_array)
-                    {
-                        if (r >= len) continue;
-                        snippet(r, -1, opt, s, data, move_list[i], base_cost);
-                    }
-                    for (int r = 0; r < len; r++)
-                    {
-                        if (data.get_mem(opt, r, -1).delta_cost - move_list[i].delta_cost < -PRECISION)
-                            move_list[i] = data.get_mem(opt, r, -1);
-                    }
-                }
-                else if (opt == "2opt*" || opt == "2exchange" || opt == "oropt_double")
-                {
-                    for (auto &r : tour_id_array)
-                    {
-                        if (r >= len) continue;
-                        for (int r1 = 0; r1 < r; r1++)
-                        {
-                            snippet(r1, r, opt, s, data, move_list[i], base_cost);
-                        }
-                        for (int r1 = r+1; r1 < len; r1++)
-                        {
-                            snippet(r, r1, opt, s, data, move_list[i], base_cost);
-                        }
-                    }
-                    for (int r1 = 0; r1 < len; r1++)
-                    {
-                        for (int r2 = r1 + 1; r2 < len; r2++)
-                        {
-                            if (data.get_mem(opt, r1, r2).delta_cost - move_list[i].delta_cost < -PRECISION)
-                                move_list[i] = data.get_mem(opt, r1, r2);
-                        }
-                    }
-                }
-                else
+                // re-evaluate the sub-neighborhoods of changed routes, then take the best over the memo
+                route_pairs(opt, len, tour_id_array, pairs);
+                scan_route_pairs(opt, pairs, s, data, ctx, workers, move_list[i], base_cost);
+                route_pairs(opt, len, std::vector<int>(), pairs);
+                for (auto &pair : pairs)
                 {
-                    std::cout << "Unknown opt: " << opt;
-                    exit(-1);
+                    Move &m = ctx.get_mem(opt, pair.first, pair.second);
+                    if (m.delta_cost - move_list[i].delta_cost < -PRECISION)
+                        move_list[i] = m;
                 }
             }
         }
@@ -1621,15 +1828,15 @@ void find_local_optima(Solution &s, Data &data, double base_cost)
     }
 }
 
-void do_local_search(Solution &s, Data &data)  // Cross-Domain Neighborhood Search (CDNS)
+void do_local_search(Solution &s, const Data &data, SearchContext &ctx)  // Cross-Domain Neighborhood Search (CDNS)
 {
     if (int(data.small_opts.size() == 0))
     {
         printf("No small stepsize operator used, directly return.\n");
         return;
     }
-    // not using local search
-    if (data.escape_local_optima == -1) return;
+    // not using local search, or out of time
+    if (ctx.escape_local_optima == -1 || ctx.deadline.expired()) return;
 
     // --------------------- remove all stations  ---------------------
     /*
@@ -1637,8 +1844,11 @@ void do_local_search(Solution &s, Data &data)  // Cross-Domain Neighborhood Sear
         all charging stations from a feasible EVRP-TW-SPD solution
         always results in a feasible VRP-TW-SPD solution.
     */
+    // with --dirty_routes, routes unchanged since CDNS returned them keep their stations
+    std::vector<char> clean(s.len(), 0);
     for (int j = 0; j< s.len(); j++ ){
                 Route &r = s.get(j);
+                if (data.dirty_routes) clean[j] = (r.version() == r.cdns_version);
                 r.customer_list = r.node_list;
                 auto &nodes = r.customer_list;
                 nodes.erase(std::remove_if(nodes.begin(), nodes.end(), 
@@ -1647,6 +1857,11 @@ void do_local_search(Solution &s, Data &data)  // Cross-Domain Neighborhood Sear
                 r.update(data);    
                 //no need to update total_cost                      
     }        
+    if (data.dirty_routes)
+    {
+        cdns_routes.fetch_add(long(clean.size()), std::memory_order_relaxed);
+        cdns_clean.fetch_add(long(std::count(clean.begin(), clean.end(), 1)), std::memory_order_relaxed);
+    }
 
     Solution item = s;
     int flag = 0;
@@ -1654,7 +1869,7 @@ void do_local_search(Solution &s, Data &data)  // Cross-Domain Neighborhood Sear
     int index_negtive_first = -1;
     int j = 0;
     for (j = 0; j< item.len(); j++ ) {
-        Route r= item.get(j);
+        Route r= item.peek(j);
         std::swap(r.node_list, r.customer_list);
         r.temp_node_list = r.customer_list;
         flag = 0;
@@ -1663,7 +1878,15 @@ void do_local_search(Solution &s, Data &data)  // Cross-Domain Neighborhood Sear
         update_route_status(r.temp_node_list,r.status_list,data,flag,new_cost,index_negtive_first); 
         if (flag == 0 || flag == 2 || flag == 3) break;
         if (flag == 1) item.get(j).total_cost = item.get(j).cal_cost(data); 
-        if (flag == 4 && !parallel_sequential_station_insertion(item, r, data, j)) break;  
+        if (flag == 4 && clean[j])
+        {
+            Route &c = item.get(j);
+            c.node_list = c.customer_list;
+            c.update(data);
+            c.total_cost = c.cal_cost(data);
+            continue;
+        }
+        if (flag == 4 && !parallel_sequential_station_insertion(item, r, data, ctx, j)) break;  
     }        
     if (j == item.len()) {                    
         item.cal_cost(data);  
@@ -1688,7 +1911,7 @@ void do_local_search(Solution &s, Data &data)  // Cross-Domain Neighborhood Sear
     
     if (data.aggressive_local_search){
         Solution s_N = s;
-        find_local_optima(s, data, s_N);
+        find_local_optima(s, data, ctx, s_N);
         std::swap(s, s_N);
     }
 
@@ -1697,7 +1920,9 @@ void do_local_search(Solution &s, Data &data)  // Cross-Domain Neighborhood Sear
     // --------------------- Conservative Local Search (CLS), must be feasiable to EVRP-TW-SPD---------------------
     if (data.conservative_local_search) {
         double base_cost=s.cost;
-        find_local_optima(s, data, base_cost);
+        if (data.dirty_routes) ctx.swap_mem_key();
+        find_local_optima(s, data, ctx, base_cost);
+        if (data.dirty_routes) ctx.swap_mem_key();
     }
 
 
@@ -1705,47 +1930,24 @@ void do_local_search(Solution &s, Data &data)  // Cross-Domain Neighborhood Sear
                 Route &r = s.get(j);
                 std::swap(r.node_list, r.customer_list);
                 r.update(data);                          
+                if (data.dirty_routes) r.cdns_version = r.version();
     } 
     s.cal_cost(data);
     //printf("CLS: %.2lf\n", s.cost);
     
     // not using large neighborhood
-    if (data.escape_local_optima == 0) return;
+    if (ctx.escape_local_optima == 0) return;
 
-    int escape_local_optima = data.escape_local_optima;
+    int escape_local_optima = ctx.escape_local_optima;
     
-    data.escape_local_optima = 0;
+    ctx.escape_local_optima = 0;
 
-    static int tmp_solution_num = int(data.destroy_opts.size()) * int(data.repair_opts.size());
-    if (data.rd_removal_insertion)
-        tmp_solution_num = 1;
-    static std::vector<Solution> s_vector(tmp_solution_num);
+    std::vector<Solution> &s_vector = ctx.s_vector;
      
     int no_improve = 0;
-    while (no_improve < escape_local_optima)
+    while (no_improve < escape_local_optima && !ctx.deadline.expired())
     {
-        for (int i = 0; i < tmp_solution_num; i++)
-            s_vector[i] = s;
-        perturb(s_vector, data);
-        int best_index = -1;
-        double best_cost = double(INFINITY);
-        for (int i = 0; i < tmp_solution_num; i++)
-        {
-            Solution s_t = s_vector[i];            
-            do_local_search(s_t, data);   
-
-            //printf("%.2lf, %.2lf\n", s.cost, s_t.cost);
-
-            if (s_t.cost - s_vector[i].cost < -PRECISION) {
-                s_vector[i]=s_t;
-            }            
-
-            if (s_vector[i].cost - best_cost < -PRECISION)
-            {
-                best_index = i;
-                best_cost = s_vector[i].cost;
-            }
-        }
+        int best_index = destroy_repair_portfolio(s, data, ctx);
         if (s_vector[best_index].cost - s.cost < -PRECISION)
         {
             s = s_vector[best_index];
@@ -1756,30 +1958,91 @@ void do_local_search(Solution &s, Data &data)  // Cross-Domain Neighborhood Sear
             no_improve++;
         }
     }
-    data.escape_local_optima = escape_local_optima;
+    ctx.escape_local_optima = escape_local_optima;
 }
 
-void perturb(std::vector<Solution> &s_vector, Data &data)
+void perturb(std::vector<Solution> &s_vector, const Data &data, SearchContext &ctx)
 {
-    int count = 0;
     if (data.rd_removal_insertion)
     {
-        int i = randint(0, int(data.destroy_opts.size())-1, data.rng);
-        int j = randint(0, int(data.repair_opts.size())-1, data.rng);
-        destroy_opt_map[data.destroy_opts[i]](s_vector[0], data);
-        repair_opt_map[data.repair_opts[j]](s_vector[0], data);
+        perturb(s_vector[0], 0, data, ctx);
         return;
     }
-    for (int i = 0; i < int(data.destroy_opts.size()); i++)
+    int pair_num = int(data.destroy_opts.size()) * int(data.repair_opts.size());
+    for (int count = 0; count < pair_num; count++)
     {
-        for (int j = 0; j < int(data.repair_opts.size()); j++)
-        {
-            destroy_opt_map[data.destroy_opts[i]](s_vector[count], data);
-            repair_opt_map[data.repair_opts[j]](s_vector[count], data);
-            // s_vector[count].check(data);
-            count++;
-        }
+        perturb(s_vector[count], count, data, ctx);
+        // s_vector[count].check(data);
     }
 }
 
+void perturb(Solution &s, int index, const Data &data, SearchContext &ctx)
+{
+    // index selects the (destroy, repair) pair, it is ignored when the pair is random
+    int i, j;
+    if (data.rd_removal_insertion)
+    {
+        i = randint(0, int(data.destroy_opts.size())-1, ctx.rng);
+        j = randint(0, int(data.repair_opts.size())-1, ctx.rng);
+    }
+    else
+    {
+        int pair = index % (int(data.destroy_opts.size()) * int(data.repair_opts.size()));
+        i = pair / int(data.repair_opts.size());
+        j = pair % int(data.repair_opts.size());
+    }
+    destroy_opt_table[data.destroy_opts[i]](s, data, ctx);
+    repair_opt_table[data.repair_opts[j]](s, data, ctx);
+}
 
+int destroy_repair_portfolio(Solution &s, const Data &data, SearchContext &ctx)
+{
+    std::vector<Solution> &s_vector = ctx.s_vector;
+    int tmp_solution_num = int(s_vector.size());
+    // one rng stream per candidate, such that the result does not depend on the number of threads
+    std::vector<unsigned int> seeds(tmp_solution_num);
+    for (auto &seed : seeds) seed = ctx.rng();
+    std::mt19937 rng = ctx.rng;
+    // worker 0 searches with ctx itself, the others with the helpers of ctx
+    int n_workers = std::max(1, std::min(ctx.threads, tmp_solution_num));
+    int threads = ctx.threads;
+    ctx.threads = std::max(1, threads / n_workers);
+    std::vector<SearchContext *> workers = ctx.workers(n_workers, data);
+    // route gaps as for the rng: each candidate starts from the state of ctx, which takes in what they learned
+    RouteProximity start = ctx.proximity;
+    std::vector<RouteProximity> learned(tmp_solution_num, start);
+    // the memo keys of --dirty_routes stay with the worker, so each worker improves fixed candidates
+    parallel_for(tmp_solution_num, n_workers, [&](int i, int w) {
+        SearchContext &worker = *workers[w];
+        worker.rng.seed(seeds[i]);
+        s_vector[i] = s;
+        if (worker.deadline.expired()) return;
+        perturb(s_vector[i], i, data, worker);   // the destroy-repair operator
+        Solution s_t = s_vector[i];
+        worker.proximity = start;
+        do_local_search(s_t, data, worker);    // perform CDNS
+        learned[i] = worker.proximity;
+
+        //printf("%.2lf, %.2lf\n", s.cost, s_t.cost);
+
+        if (s_t.cost - s_vector[i].cost < -PRECISION) {
+            s_vector[i]=s_t;
+        }
+    }, data.dirty_routes);
+    ctx.rng = rng;
+    ctx.threads = threads;
+    ctx.proximity = start;
+    for (auto &p : learned) ctx.proximity.merge(start, p);
+
+    int best_index = -1;
+    double best_cost = double(INFINITY);
+    for (int i = 0; i < tmp_solution_num; i++)
+    {
+        if (s_vector[i].cost - best_cost < -PRECISION)
+        {
+            best_index = i;
+            best_cost = s_vector[i].cost;
+        }
+    }
+    return best_index;
+}
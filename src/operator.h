@@ -16,24 +16,33 @@
 
 /* construct a complete solution by inserting unrouted nodes into s 
 without considering existing routes in s*/
-void new_route_insertion(Solution &s, Data &data);
+void new_route_insertion(Solution &s, const Data &data, Workspace &ctx);
 
-void new_route_insertion(Solution &s, Data &data, int initial_node);
+void new_route_insertion(Solution &s, const Data &data, Workspace &ctx, int initial_node);
 
 /* do local search to s */
-void do_local_search(Solution &s, Data &data);
+void do_local_search(Solution &s, const Data &data, SearchContext &ctx);
 /* perturb solution s by destroy and repair */
-void perturb(std::vector<Solution> &s_vector, Data &data);
-void random_removal(Solution &s, Data &data);
-void related_removal(Solution &s, Data &data);
-void regret_insertion(Solution &s, Data &data);
-void greedy_insertion(Solution &s, Data &data);
+void perturb(std::vector<Solution> &s_vector, const Data &data, SearchContext &ctx);
+void perturb(Solution &s, int index, const Data &data, SearchContext &ctx);
+/* one LNS iteration: perturb copies of s and improve them by CDNS, return the index of the best one in ctx.s_vector */
+int destroy_repair_portfolio(Solution &s, const Data &data, SearchContext &ctx);
+void random_removal(Solution &s, const Data &data, SearchContext &ctx);
+void related_removal(Solution &s, const Data &data, SearchContext &ctx);
+void regret_insertion(Solution &s, const Data &data, Workspace &ctx);
+void greedy_insertion(Solution &s, const Data &data, Workspace &ctx);
 
 /* In future, we could use memory to store the best solutions in sub neighborhoods,
 such that we could avoid repeated computation
  */
-void two_opt(int r1, int r2, Solution &s, Data &data, Move &m, double &base_cost);
-void two_opt_star(int r1, int r2, Solution &s, Data &data, Move &m, double &base_cost);
-void or_opt_single(int r1, int r2, Solution &s, Data &data, Move &m, double &base_cost);
-void or_opt_double(int r1, int r2, Solution &s, Data &data, Move &m, double &base_cost);
-void two_exchange(int r1, int r2, Solution &s, Data &data, Move &m, double &base_cost);
+void two_opt(int r1, int r2, Solution &s, const Data &data, Workspace &ctx, Move &m, double &base_cost);
+void two_opt_star(int r1, int r2, Solution &s, const Data &data, Workspace &ctx, Move &m, double &base_cost);
+void or_opt_single(int r1, int r2, Solution &s, const Data &data, Workspace &ctx, Move &m, double &base_cost);
+void or_opt_double(int r1, int r2, Solution &s, const Data &data, Workspace &ctx, Move &m, double &base_cost);
+void two_exchange(int r1, int r2, Solution &s, const Data &data, Workspace &ctx, Move &m, double &base_cost);
+/* inter-route moves checked against the granular neighbourhoods (--granular) and those skipped, over all threads */
+void granular_stats(long &checked, long &skipped);
+/* route pairs listed for the inter-route opts with --route_proximity and those skipped, over all threads */
+void route_proximity_stats(long &checked, long &skipped);
+/* with --dirty_routes, sub-neighborhoods listed and those skipped as known to hold no improving move, and routes entering CDNS and those left unchanged since its last call */
+void dirty_route_stats(long &listed, long &reused, long &routes, long &clean);
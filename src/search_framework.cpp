@@ -1,16 +1,20 @@
 #include "search_framework.h"
-extern clock_t find_best_time;
-extern clock_t find_bks_time;
-extern int find_best_run;
-extern int find_best_gen;
-extern int find_bks_run;
-extern int find_bks_gen;
-extern bool find_better;
-extern long call_count_move_eval;
-extern long mean_duration_move_eval;
-
-void update_best_solution(Solution &s, Solution &best_s, clock_t used, int run, int gen, Data &data, int level,  clock_t stime0, double &update_value)
+#include <mutex>
+#include "checkpoint.h"
+
+volatile sig_atomic_t interrupted = 0;
+
+void update_best_solution(Solution &s, Solution &best_s, clock_t used, int run, int gen, const Data &data, SearchContext &ctx, int level,  clock_t stime0, double &update_value)
 {
+    // a concurrent search reports the best solution of all searches from the main search context
+    if (level == 1 && ctx.shared != nullptr)
+    {
+        if (s.cost - best_s.cost < -PRECISION) best_s = s;
+        std::lock_guard<std::mutex> lock(ctx.shared->mutex);
+        SearchContext &main = ctx.shared->main;
+        update_best_solution(s, main.best_s, used, run, gen, data, main, level, stime0, update_value);
+        return;
+    }
     if (s.cost - best_s.cost < -PRECISION)
     {
         double delta = s.cost - best_s.cost;
@@ -22,21 +26,21 @@ void update_best_solution(Solution &s, Solution &best_s, clock_t used, int run,
         }
         else  {
             update_value += delta;
-            clock_t used0 = (clock() - stime0) / CLOCKS_PER_SEC;
+            clock_t used0 = (wall_clock() - stime0) / CLOCKS_PER_SEC;
             printf("Best solution update: %.4f\n", update_value);
  
         }
 
-        find_best_time = used;
-        find_best_run = run;
-        find_best_gen = gen;
-        if (!find_better && (std::abs(best_s.cost - data.bks) < PRECISION ||
+        ctx.find_best_time = used;
+        ctx.find_best_run = run;
+        ctx.find_best_gen = gen;
+        if (!ctx.find_better && (std::abs(best_s.cost - data.bks) < PRECISION ||
                              (best_s.cost - data.bks < -PRECISION)))
         {
-            find_better = true;
-            find_bks_time = used;
-            find_bks_run = run;
-            find_bks_gen = gen;
+            ctx.find_better = true;
+            ctx.find_bks_time = used;
+            ctx.find_bks_run = run;
+            ctx.find_bks_gen = gen;
         }
     }
 
@@ -44,8 +48,7 @@ void update_best_solution(Solution &s, Solution &best_s, clock_t used, int run,
 }
 
 // barycenter clustering decomposition (BCD)
-void decomposition_cluster(vector<Solution> &pop, vector<double> &pop_fit, vector<int> &pop_argrank, Data &data, clock_t stime){  
-    clock_t used = 0; 
+void decomposition_cluster(vector<Solution> &pop, vector<double> &pop_fit, vector<int> &pop_argrank, const Data &data, SearchContext &ctx, clock_t stime){  
     int sub_problem_num = data.subproblem_range;
     printf("sub_problem_num: %d\n", sub_problem_num);
     int Max_customer_num_per_subproblem = data.customer_num / sub_problem_num + (data.customer_num % sub_problem_num != 0);
@@ -81,27 +84,70 @@ void decomposition_cluster(vector<Solution> &pop, vector<double> &pop_fit, vecto
         std::vector<Solution> s_d(sub_problem_num);
         std::vector<double> s_d_fit(sub_problem_num);
         for (int j = 0; j< pop[i].len(); j++ ){
-            Route &r = pop[i].get(j);
-            s_d[r.cluster].append(r);
-            std::vector<int> &nl = r.customer_list;
+            const Route &r = pop[i].peek(j);
+            s_d[r.cluster].append(pop[i], j);
+            const std::vector<int> &nl = r.customer_list;
             int customer_num_in_route = nl.size()-2;
             auto start = nl.begin() + 1;  
             auto end = nl.begin() + customer_num_in_route + 1;   
             subproblem[r.cluster].insert(subproblem[r.cluster].end(), start, end);  
         }
-        // solve all subprolems sequentially
-        Solution s_m;
-        s_m.cost = 0;
-        double update_cost = pop[i].cost;
-        for (int h = 0; h < sub_problem_num; ++h) { 
+        // solve all subprolems in parallel, they are disjoint since each route belongs to exactly one cluster
+        vector<int> active;
+        for (int h = 0; h < sub_problem_num; ++h) {
             if (clusterSize[h] > 0){
                 s_d[h].cal_cost(data);
                 s_d_fit[h] = s_d[h].cost;
-                printf("subproblem %d, customer: %d\n", h+1, clusterSize[h]);
+                active.push_back(h);
+            }
+        }
+        int n_active = int(active.size());
+        int n_workers = std::max(1, std::min(ctx.threads, n_active));
+        // the time left is split across the clusters not started yet by size, and over the workers not
+        // busy with another cluster, such that all workers finish at about the same time
+        std::mutex budget_mutex; // guards waiting and running
+        int waiting = 0; // customers of the clusters not started yet
+        int running = 0; // clusters being searched
+        for (int h : active) waiting += clusterSize[h];
+        // subproblems start from the route gaps learned so far, what they learn is taken in by cluster
+        RouteProximity start = ctx.proximity;
+        vector<RouteProximity> learned(n_active, start);
+        // a seed per cluster, drawn in cluster order such that the subproblems do not repeat one random stream
+        vector<int> seeds(n_active);
+        for (int k = 0; k < n_active; k++)
+        {
+            seeds[k] = int(ctx.rng());
+            printf("subproblem %d, customer: %d\n", active[k]+1, clusterSize[active[k]]);
+        }
+        vector<double> improvement(sub_problem_num, 0.0);
+        vector<double> sub_cost(sub_problem_num); // cost of the best solution of each improved subproblem
+        vector<tuple<clock_t, int, int>> find_best(sub_problem_num); // when the best solution of each subproblem was found
+        Solution s_m;
+        s_m.cost = 0;
+        double update_cost = pop[i].cost;
+        parallel_for(n_active, n_workers, [&](int k, int) {
+                int h = active[k];
                 Solution best_s = s_d[h];
                 // printf("%.2lf ", best_s.cost);
                 // best_s.cost = double(INFINITY);
                 Data sub_data(data, subproblem[h]);
+                sub_data.seed = seeds[k];
+                sub_data.threads = std::max(1, ctx.threads / n_workers);
+                {
+                    std::lock_guard<std::mutex> lock(budget_mutex);
+                    if (data.tmax != NO_LIMIT)
+                    {
+                        double used_sec = (wall_clock() - stime) / (CLOCKS_PER_SEC*1.0);
+                        double left_sec = std::max(0.0, data.tmax - used_sec);
+                        double budget = left_sec * clusterSize[h] / waiting * (n_workers - running);
+                        sub_data.tmax = int(std::ceil(used_sec + std::min(budget, left_sec)));
+                    }
+                    waiting -= clusterSize[h];
+                    running++;
+                }
+                SearchContext sub_ctx(sub_data);
+                sub_ctx.deadline = ctx.deadline;
+                sub_ctx.proximity = start;
                 std::map<int, int> mapping;
                 // main problem to subproblems mapping
                 mapping.insert(std::make_pair(0, 0));
@@ -129,18 +175,17 @@ void decomposition_cluster(vector<Solution> &pop, vector<double> &pop_fit, vecto
                 }
                 best_s.cal_cost(sub_data);
                 // printf("%.2lf\n", best_s.cost);
-                if (data.tmax != NO_LIMIT && (clock() - stime) / (CLOCKS_PER_SEC*1.0) > clock_t(data.tmax))
+                if (sub_ctx.deadline.expired())
                 {                
                     // time_exhausted = true;
                     // break;
                 }
-                else search_framework(sub_data, best_s, 0, stime, update_cost);
+                else search_framework(sub_data, sub_ctx, best_s, 0, stime, update_cost);
 
                 if (best_s.cost -  s_d_fit[h] < -PRECISION) { //subproblem is optimized
 
-                        update_cost += best_s.cost -  s_d_fit[h];
-                        used = (clock() - stime) / CLOCKS_PER_SEC;
-
+                        improvement[h] = best_s.cost - s_d_fit[h];
+                        find_best[h] = std::make_tuple(sub_ctx.find_best_time, sub_ctx.find_best_run, sub_ctx.find_best_gen);
                         s_d_fit[h] = best_s.cost;
                         // node number restoration
                         Solution s_t;
@@ -167,18 +212,30 @@ void decomposition_cluster(vector<Solution> &pop, vector<double> &pop_fit, vecto
                             s_t.append(r);
                         }
                         s_t.cal_cost(data);
-                        printf("%.2lf, %.2lf, %.2lf\n", s_d[h].cost, s_t.cost, best_s.cost);
+                        sub_cost[h] = best_s.cost;
                         s_d[h] =s_t;           
                 }
-             
-                // the solutions from all subproblems are assembled to construct a complete solution
+                learned[k] = sub_ctx.proximity;
+                std::lock_guard<std::mutex> lock(budget_mutex);
+                running--;
+        });
+
+        for (auto &p : learned) ctx.proximity.merge(start, p);
+
+        // the solutions from all subproblems are assembled to construct a complete solution
+        for (int k = 0; k < n_active; k++) {
+                int h = active[k];
+                if (improvement[h] < -PRECISION) {
+                        printf("%.2lf, %.2lf, %.2lf\n", s_d_fit[h] - improvement[h], s_d[h].cost, sub_cost[h]);
+                        update_cost += improvement[h];
+                        ctx.find_best_time = get<0>(find_best[h]);
+                        ctx.find_best_run = get<1>(find_best[h]);
+                        ctx.find_best_gen = get<2>(find_best[h]);
+                }
                 for (int j = 0; j< s_d[h].len(); j++ ){
-                    Route &r = s_d[h].get(j);
-                    s_m.append(r);
+                    s_m.append(s_d[h], j);
                 }    
                 s_m.cost += s_d_fit[h];                         
-
-            }
         }
 
         pop[i] = s_m;
@@ -187,79 +244,86 @@ void decomposition_cluster(vector<Solution> &pop, vector<double> &pop_fit, vecto
     }   
 }
 
-void initialization(vector<Solution> &pop, vector<double> &pop_fit, vector<int> &pop_argrank, Data &data)
+void initialization(vector<Solution> &pop, vector<double> &pop_fit, vector<int> &pop_argrank, const Data &data, SearchContext &ctx)
 {
     int len = int(pop.size());
-    printf("Initialization, using %s method\n", data.init.c_str());
-    if (data.init == RCRS)
+    std::string init = data.init;
+    if (!data.initial_solution.empty())
+    {
+        // warm start: the given solution is pop[0], the others are built from it as in PERTURB
+        load_initial_solution(data.initial_solution, data, pop[0], ctx);
+        init = PERTURB;
+    }
+    printf("Initialization, using %s method\n", init.c_str());
+    if (init == RCRS)
     {
         for (int i = 0; i < len; i++)
         {
             pop[i].clear(data);
         }
-        data.n_insert = RCRS;
-        data.ksize = data.k_init;
+        ctx.n_insert = RCRS;
+        ctx.ksize = data.k_init;
         for (int i = 0; i < len; i++)
         {
             // printf("individual %d:\n",i);
-            data.lambda_gamma = data.latin[i];
-            if (len == 1) data.lambda_gamma = std::make_tuple(0.5, 0.5);
-            // printf("lambda, gamma: %f, %f\n", get<0>(data.lambda_gamma), get<1>(data.lambda_gamma));
-            new_route_insertion(pop[i], data);
+            ctx.lambda_gamma = data.latin[i];
+            if (len == 1) ctx.lambda_gamma = std::make_tuple(0.5, 0.5);
+            // printf("lambda, gamma: %f, %f\n", get<0>(ctx.lambda_gamma), get<1>(ctx.lambda_gamma));
+            new_route_insertion(pop[i], data, ctx);
         }
     }
-    else if (data.init == RCRS_RANDOM)
+    else if (init == RCRS_RANDOM)
     {
         for (int i = 0; i < len; i++)
         {
             pop[i].clear(data);
         }
-        data.n_insert = RCRS;
-        data.ksize = data.k_init;
+        ctx.n_insert = RCRS;
+        ctx.ksize = data.k_init;
         for (int i = 0; i < len; i++)
         {
-            data.lambda_gamma = std::make_tuple(rand(0, 1, data.rng), rand(0, 1, data.rng));
-            printf("lambda, gamma: %f, %f\n", get<0>(data.lambda_gamma), get<1>(data.lambda_gamma));
-            new_route_insertion(pop[i], data);
+            ctx.lambda_gamma = std::make_tuple(rand(0, 1, ctx.rng), rand(0, 1, ctx.rng));
+            printf("lambda, gamma: %f, %f\n", get<0>(ctx.lambda_gamma), get<1>(ctx.lambda_gamma));
+            new_route_insertion(pop[i], data, ctx);
         }
     }
-    else if (data.init == TD)
+    else if (init == TD)
     {
         for (int i = 0; i < len; i++)
         {
             pop[i].clear(data);
         }
-        data.ksize = data.k_init;
-        data.n_insert = TD;
-        for (int i = 0; i < len; i++) {new_route_insertion(pop[i], data);}
+        ctx.ksize = data.k_init;
+        ctx.n_insert = TD;
+        for (int i = 0; i < len; i++) {new_route_insertion(pop[i], data, ctx);}
     }
-    else if (data.init == PERTURB) // Population Initialization
+    else if (init == PERTURB) // Population Initialization
     {
         for (int i = 1; i < len; i++)
         {
             pop[i].clear(data);
         }
-        data.ksize = data.k_init;
-        data.n_insert = RCRS;
+        ctx.ksize = data.k_init;
+        ctx.n_insert = RCRS;
         std::vector<Solution> s_vector(1);
-        double w1 = data.destroy_ratio_l, w2 = data.destroy_ratio_u;
+        double w1 = ctx.destroy_ratio_l, w2 = ctx.destroy_ratio_u;
         for (int i = 1; i < len; i++){
             if (i % 2 == 1){     // the individual S_i with odd index i comes from the destroy-repair
                     double w = 1.0 * i / len;
-                    data.destroy_ratio_l = w;
-                    data.destroy_ratio_u = w;                   
+                    ctx.destroy_ratio_l = w;
+                    ctx.destroy_ratio_u = w;                   
                     s_vector[0] = pop[0];
-                    perturb(s_vector, data); 
+                    perturb(s_vector[0], i / 2, data, ctx); 
                     pop[i] = s_vector[0];
             }
             else{               // the individual S_i with even index i, it is generated by RCRS
-                    data.lambda_gamma = data.latin[i];
-                    new_route_insertion(pop[i], data);               
+                    ctx.lambda_gamma = data.latin[i];
+                    new_route_insertion(pop[i], data, ctx);               
             }
         }
-        shuffle(pop.begin(), pop.end(), data.rng);
-        data.destroy_ratio_l = w1;
-        data.destroy_ratio_u = w2;
+        shuffle(pop.begin(), pop.end(), ctx.rng);
+        ctx.destroy_ratio_l = w1;
+        ctx.destroy_ratio_u = w2;
     }
     else
     {
@@ -279,21 +343,21 @@ void initialization(vector<Solution> &pop, vector<double> &pop_fit, vector<int>
     
 }
 
-void tournament(vector<int> &indice, vector<double> pop_fit, int boundray, Data &data)
+void tournament(vector<int> &indice, vector<double> pop_fit, int boundray, std::mt19937 &rng)
 {
-    int index_index_1 = randint(0, boundray, data.rng);
+    int index_index_1 = randint(0, boundray, rng);
     // swap two values
     int tmp = indice[index_index_1];
     indice[index_index_1] = indice[boundray];
     indice[boundray] = tmp;
-    int index_index_2 = randint(0, boundray-1, data.rng);
+    int index_index_2 = randint(0, boundray-1, rng);
     tmp = indice[index_index_2];
     indice[index_index_2] = indice[boundray-1];
     indice[boundray-1] = tmp;
     // select one value from indice[boundray-1] and indice[boundray]
     int selected;
     if (abs(pop_fit[indice[boundray]] - pop_fit[indice[boundray-1]]) < PRECISION)
-        selected = randint(boundray-1, boundray, data.rng);
+        selected = randint(boundray-1, boundray, rng);
     else if (pop_fit[indice[boundray]] < pop_fit[indice[boundray-1]])
         selected = boundray;
     else
@@ -303,12 +367,12 @@ void tournament(vector<int> &indice, vector<double> pop_fit, int boundray, Data
     indice[boundray] = tmp;
 }
 
-void select_parents(vector<Solution> &pop, vector<double> pop_fit, vector<tuple<int, int>> &p_indice, Data &data)
+void select_parents(vector<Solution> &pop, vector<double> pop_fit, vector<tuple<int, int>> &p_indice, const Data &data, std::mt19937 &rng)
 {
     int len = data.p_size;
     vector<int> indice(len);
     iota(indice.begin(), indice.end(), 0);
-    shuffle(indice.begin(), indice.end(), data.rng);
+    shuffle(indice.begin(), indice.end(), rng);
     if (data.selection == CIRCLE)
     {
         for (int i = 0; i < len - 1; i++)
@@ -323,8 +387,8 @@ void select_parents(vector<Solution> &pop, vector<double> pop_fit, vector<tuple<
     {
         for (int i = 0; i < len; i++)
         {
-            tournament(indice, pop_fit, len-1, data);
-            tournament(indice, pop_fit, len-2, data);
+            tournament(indice, pop_fit, len-1, rng);
+            tournament(indice, pop_fit, len-2, rng);
             get<0>(p_indice[i]) = indice[len-1];
             get<1>(p_indice[i]) = indice[len-2];
         }
@@ -333,11 +397,11 @@ void select_parents(vector<Solution> &pop, vector<double> pop_fit, vector<tuple<
     {
         for (int i = 0; i < len; i++)
         {
-            int index_index_1 = randint(0, len-1, data.rng);
+            int index_index_1 = randint(0, len-1, rng);
             int tmp = indice[index_index_1];
             indice[index_index_1] = indice[len-1];
             indice[len-1] = tmp;
-            int index_index_2 = randint(0, len-2, data.rng);
+            int index_index_2 = randint(0, len-2, rng);
             get<0>(p_indice[i]) = indice[len-1];
             get<1>(p_indice[i]) = indice[index_index_2];
         }
@@ -348,21 +412,35 @@ void select_parents(vector<Solution> &pop, vector<double> pop_fit, vector<tuple<
     }
 }
 
-void update_candidate_routes(Route &r, std::unordered_set<int> &inserted, Solution &s, vector<int> &candidate_r, Data &data)
+// the customers of every route of s as a bitset of words 64-bit words, route r at [r * words, (r + 1) * words)
+static void customer_bits(const Solution &s, const Data &data, int words, vector<unsigned long long> &bits)
 {
-    for (auto &node : r.node_list) {
-        if (data.node[node].type == 1) inserted.insert(node);  //count customers in s
+    bits.assign(size_t(s.len()) * words, 0);
+    for (int r = 0; r < s.len(); r++)
+    {
+        unsigned long long *b = &bits[size_t(r) * words];
+        for (int node : s.peek(r).node_list)
+        {
+            if (data.node[node].type == 1) b[node / 64] |= 1ULL << (node % 64);
+        }
     }
+}
+
+void update_candidate_routes(const unsigned long long *route, vector<unsigned long long> &inserted,
+                             const vector<unsigned long long> &bits, vector<int> &candidate_r)
+{
+    // add the customers of route to inserted, and drop the candidates serving one of them (swap and pop)
+    int words = int(inserted.size());
+    for (int w = 0; w < words; w++) inserted[w] |= route[w];
     int i = 0;
     int len = int(candidate_r.size());
     while (i < len)
     {
-        Route &r = s.get(candidate_r[i]);
+        const unsigned long long *b = &bits[size_t(candidate_r[i]) * words];
         bool flag = true;
-        for (auto &node : r.node_list)
+        for (int w = 0; w < words; w++)
         {
-            if (node == data.DC) continue;
-            if (inserted.count(node) == 1)
+            if (b[w] & inserted[w])
             {
                 flag = false;
                 break;
@@ -370,7 +448,8 @@ void update_candidate_routes(Route &r, std::unordered_set<int> &inserted, Soluti
         }
         if (!flag)
         {
-            candidate_r.erase(candidate_r.begin() + i);
+            candidate_r[i] = candidate_r[len - 1];
+            candidate_r.pop_back();
             len--;
         }
         else
@@ -378,7 +457,7 @@ void update_candidate_routes(Route &r, std::unordered_set<int> &inserted, Soluti
     }
 }
 
-void crossover(Solution &s1, Solution &s2, Solution &ch, double &child_fit, Data &data)
+void crossover(Solution &s1, Solution &s2, Solution &ch, double &child_fit, const Data &data, Workspace &ctx)
 {
 
     if (data.no_crossover)
@@ -391,62 +470,81 @@ void crossover(Solution &s1, Solution &s2, Solution &ch, double &child_fit, Data
     vector<int> candidate_r_2(s2.len());
     std::iota(candidate_r_2.begin(), candidate_r_2.end(), 0);
     int count = 0;
-    std::unordered_set<int> inserted;
-    inserted.reserve(data.customer_num + 1);
+    int words = data.customer_num / 64 + 1;
+    vector<unsigned long long> bits_1, bits_2;
+    customer_bits(s1, data, words, bits_1);
+    customer_bits(s2, data, words, bits_2);
+    vector<unsigned long long> inserted(words, 0);
 
     while (true)
     {
         if (int(candidate_r_1.size()) == 0) break;
-        int selected = randint(0, int(candidate_r_1.size())-1, data.rng);
-        Route &r_1 = s1.get(candidate_r_1[selected]);
-        ch.append(r_1);
-        update_candidate_routes(r_1, inserted, s2, candidate_r_2, data);
+        int selected = randint(0, int(candidate_r_1.size())-1, ctx.rng);
+        ch.append(s1, candidate_r_1[selected]);
+        update_candidate_routes(&bits_1[size_t(candidate_r_1[selected]) * words], inserted, bits_2, candidate_r_2);
         if (int(candidate_r_2.size()) == 0) break;
-        selected = randint(0, int(candidate_r_2.size())-1, data.rng);
-        Route &r_2 = s2.get(candidate_r_2[selected]);
-        ch.append(r_2);
-        update_candidate_routes(r_2, inserted, s1, candidate_r_1, data);
+        selected = randint(0, int(candidate_r_2.size())-1, ctx.rng);
+        ch.append(s2, candidate_r_2[selected]);
+        update_candidate_routes(&bits_2[size_t(candidate_r_2[selected]) * words], inserted, bits_1, candidate_r_1);
     }
     // call insertion
     if (data.cross_repair == RCRS)
     {
-        data.n_insert = RCRS;
-        data.ksize = data.k_crossover;
+        ctx.n_insert = RCRS;
+        ctx.ksize = data.k_crossover;
         // using random lambda and gamma
-        data.lambda_gamma = std::make_tuple(rand(0, 1, data.rng), rand(0, 1, data.rng));
-        // printf("lambda, gamma: %f, %f\n", get<0>(data.lambda_gamma), get<1>(data.lambda_gamma));
-        new_route_insertion(ch, data);
+        ctx.lambda_gamma = std::make_tuple(rand(0, 1, ctx.rng), rand(0, 1, ctx.rng));
+        // printf("lambda, gamma: %f, %f\n", get<0>(ctx.lambda_gamma), get<1>(ctx.lambda_gamma));
+        new_route_insertion(ch, data, ctx);
     }
     else if (data.cross_repair == TD)
     {
-        data.ksize = data.k_crossover;
-        data.n_insert = TD;
-        new_route_insertion(ch, data);
+        ctx.ksize = data.k_crossover;
+        ctx.n_insert = TD;
+        new_route_insertion(ch, data, ctx);
     }
     else if (data.cross_repair == REGRET)
-        regret_insertion(ch, data);
+        regret_insertion(ch, data, ctx);
     
     child_fit = ch.cost;
 }
 
-void crossover(vector<Solution> &pop, Data &data, vector<tuple<int,int>> &p_indice, vector<Solution> &child, vector<double> &child_fit)
+void crossover(vector<Solution> &pop, const Data &data, SearchContext &ctx, vector<tuple<int,int>> &p_indice, vector<Solution> &child, vector<double> &child_fit)
 {
     cout << "Do crossover." << endl;
-    int count = 0;
-    for (auto &index_t : p_indice)
+    // draw the parent order and a seed of every child up front,
+    // such that the children only depend on the seed, not on the number of threads
+    int n = int(p_indice.size());
+    vector<bool> swapped(n);
+    vector<unsigned int> seeds(n);
+    for (int count = 0; count < n; count++)
     {
-        if (randint(0, 1, data.rng) == 0)
-            crossover(pop[get<0>(index_t)], pop[get<1>(index_t)], child[count], child_fit[count] ,data);
-        else
-            crossover(pop[get<1>(index_t)], pop[get<0>(index_t)], child[count], child_fit[count], data);
-        count++;
-        //cout << "Child " << count << ". Parent Indice: (" << p1 <<\
-                "," << p2 << "). Cost: " << child[count-1].cost << endl;
+        swapped[count] = (randint(0, 1, ctx.rng) != 0);
+        seeds[count] = ctx.rng();
     }
+    // children only read their parents, worker 0 builds with ctx itself, the others with workspaces of their own
+    std::mt19937 rng = ctx.rng;
+    int threads = ctx.threads;
+    int n_workers = std::max(1, std::min(threads, n));
+    vector<Workspace> workers = ctx.fork(n_workers, std::max(1, threads / n_workers), data);
+    ctx.threads = std::max(1, threads / n_workers);
+    parallel_for(n, n_workers, [&](int count, int w) {
+        Workspace &worker = (w == 0) ? ctx : workers[w - 1];
+        worker.rng.seed(seeds[count]);
+        auto &index_t = p_indice[count];
+        if (!swapped[count])
+            crossover(pop[get<0>(index_t)], pop[get<1>(index_t)], child[count], child_fit[count], data, worker);
+        else
+            crossover(pop[get<1>(index_t)], pop[get<0>(index_t)], child[count], child_fit[count], data, worker);
+        //cout << "Child " << count+1 << ". Parent Indice: (" << p1 <<\
+                "," << p2 << "). Cost: " << child[count].cost << endl;
+    });
+    ctx.threads = threads;
+    ctx.rng = rng;
 }
 
 void output(vector<Solution> &pop, vector<double> pop_fit, vector<int> pop_argrank,\
-            Data &data, bool output_complete=false)
+            const Data &data, bool output_complete=false)
 {
     int len = int(pop.size());
     double best_cost = pop_fit[pop_argrank[0]];
@@ -462,85 +560,91 @@ void output(vector<Solution> &pop, vector<double> pop_fit, vector<int> pop_argra
     // }
 }
 
-void local_search(vector<Solution> &pop, vector<double> &pop_fit, vector<int> &pop_argrank, Data &data)
+void local_search(vector<Solution> &pop, vector<double> &pop_fit, vector<int> &pop_argrank, const Data &data, SearchContext &ctx)
 {
     //printf("Do local search\n");
 
     int len = int(pop.size());
+    // decide which individuals to search and draw a seed for each of them up front,
+    // such that the result only depends on the seed, not on the number of threads
+    vector<int> selected;
+    vector<unsigned int> seeds;
     for (int i = 0; i < len; i++)
     {
-        if (rand(0, 1, data.rng) < data.ls_prob)
+        if (rand(0, 1, ctx.rng) < data.ls_prob)
         {
-                // cout << "Individual " << i+1 << ". Before Cost " << pop[i].cost << ".\n";
-
-                Solution s = pop[i];
-                // clock_t stime1 = clock();
-                do_local_search(s, data);   // perform CDNS
-                // double used_sec1 = (clock() - stime1) / (CLOCKS_PER_SEC*1.0);
-                // printf("%d, %.2lf, %.2lf, %.2lf sec\n", i, pop_fit[i], s.cost, used_sec1);
-                if (s.cost - pop_fit[i] < -PRECISION) {
-                    
-                    pop_fit[i] = s.cost;
-                    pop[i]=s;
-
-                }
+            selected.push_back(i);
+            seeds.push_back(ctx.rng());
+        }
+    }
+    int n = int(selected.size());
+    // worker 0 searches with ctx itself, the others with the helpers of ctx
+    std::mt19937 rng = ctx.rng;
+    int threads = ctx.threads;
+    int n_workers = std::max(1, std::min(threads, n));
+    ctx.threads = std::max(1, threads / n_workers);
+    vector<SearchContext *> workers = ctx.workers(n_workers, data);
+    // each individual is searched from the route gaps ctx learned so far, such that the result does
+    // not depend on which worker searched which individual. ctx takes in what they learned in order
+    RouteProximity start = ctx.proximity;
+    vector<RouteProximity> learned(n, start);
+    vector<Solution> result(n);
+    // with --dirty_routes a worker keeps the memo keys of the individuals it searched, every worker
+    // then searches the same individuals in every run
+    parallel_for(n, n_workers, [&](int k, int w) {
+        SearchContext &worker = *workers[w];
+        worker.rng.seed(seeds[k]);
+        worker.proximity = start;
+        // cout << "Individual " << selected[k]+1 << ". Before Cost " << pop[selected[k]].cost << ".\n";
+        result[k] = pop[selected[k]];
+        do_local_search(result[k], data, worker);   // perform CDNS
+        learned[k] = worker.proximity;
+    }, data.dirty_routes);
+    ctx.threads = threads;
+    ctx.rng = rng;
+    ctx.proximity = start;
+    for (auto &p : learned) ctx.proximity.merge(start, p);
+    for (int k = 0; k < n; k++)
+    {
+        int i = selected[k];
+        if (result[k].cost - pop_fit[i] < -PRECISION) {
             
+            pop_fit[i] = result[k].cost;
+            pop[i] = result[k];
+
         }
     }
     argsort(pop_fit, pop_argrank, len);
 }
 
-void large_neighbourhood_search(vector<Solution> &pop, vector<double> &pop_fit, vector<int> &pop_argrank, Data &data)
+void large_neighbourhood_search(vector<Solution> &pop, vector<double> &pop_fit, vector<int> &pop_argrank, const Data &data, SearchContext &ctx)
 {
     int len = int(pop.size());
     for (int i = 0; i < len; i++)
     {
-        if (rand(0, 1, data.rng) < data.ls_prob)
+        if (rand(0, 1, ctx.rng) < data.ls_prob)
         {
                 // cout << "Individual " << i+1 << ". Before Cost " << pop[i].cost << ".\n";
 
                 Solution s = pop[i];
-                // clock_t stime1 = clock();
+                // clock_t stime1 = wall_clock();
 
                 // not using large neighborhood
-                if (data.escape_local_optima == 0) return;
+                if (ctx.escape_local_optima == 0) return;
                 
                 // large neighborhood search
                 
-                int escape_local_optima = data.escape_local_optima;
+                int escape_local_optima = ctx.escape_local_optima;
                 
-                data.escape_local_optima = 0;
+                ctx.escape_local_optima = 0;
 
-                static int tmp_solution_num = int(data.destroy_opts.size()) * int(data.repair_opts.size());
-                if (data.rd_removal_insertion)
-                    tmp_solution_num = 1;
-                static std::vector<Solution> s_vector(tmp_solution_num);
+                std::vector<Solution> &s_vector = ctx.s_vector;
                 
                 int no_improve = 0;
-                while (no_improve < escape_local_optima)
+                while (no_improve < escape_local_optima && !ctx.deadline.expired())
                 {
-                    for (int i = 0; i < tmp_solution_num; i++)
-                        s_vector[i] = s;
-                    perturb(s_vector, data);   // the destroy-repair operator
-                    int best_index = -1;
-                    double best_cost = double(INFINITY);
-                    for (int i = 0; i < tmp_solution_num; i++)
-                    {
-                        Solution s_t = s_vector[i];            
-                        do_local_search(s_t, data);    // perform CDNS
-
-                        //printf("%.2lf, %.2lf\n", s.cost, s_t.cost);
-
-                        if (s_t.cost - s_vector[i].cost < -PRECISION) {
-                            s_vector[i]=s_t;
-                        }            
-
-                        if (s_vector[i].cost - best_cost < -PRECISION)
-                        {
-                            best_index = i;
-                            best_cost = s_vector[i].cost;
-                        }
-                    }
+                    // destroy-repair candidates improved by CDNS, in parallel
+                    int best_index = destroy_repair_portfolio(s, data, ctx);
                     if (s_vector[best_index].cost - s.cost < -PRECISION)
                     {
                         s = s_vector[best_index];
@@ -551,9 +655,9 @@ void large_neighbourhood_search(vector<Solution> &pop, vector<double> &pop_fit,
                         no_improve++;
                     }
                 }
-                data.escape_local_optima = escape_local_optima; 
+                ctx.escape_local_optima = escape_local_optima; 
 
-                // double used_sec1 = (clock() - stime1) / (CLOCKS_PER_SEC*1.0);
+                // double used_sec1 = (wall_clock() - stime1) / (CLOCKS_PER_SEC*1.0);
                 // printf("%d, %.2lf, %.2lf, %.2lf sec\n", i, pop_fit[i], s.cost, used_sec1);
                 if (s.cost - pop_fit[i] < -PRECISION) {
                     
@@ -567,7 +671,7 @@ void large_neighbourhood_search(vector<Solution> &pop, vector<double> &pop_fit,
     argsort(pop_fit, pop_argrank, len);
 }
 
-void replacement(vector<Solution> &pop, vector<tuple<int, int>> &p_indice, vector<Solution> &child, vector<double> &pop_fit, vector<int> &pop_argrank, vector<double> &child_fit, vector<int> &child_argrank, Data &data)
+void replacement(vector<Solution> &pop, vector<tuple<int, int>> &p_indice, vector<Solution> &child, vector<double> &pop_fit, vector<int> &pop_argrank, vector<double> &child_fit, vector<int> &child_argrank, const Data &data)
 {
     int len = int(child.size());
     if (data.replacement == ONE_ON_ONE)
@@ -603,14 +707,167 @@ void replacement(vector<Solution> &pop, vector<tuple<int, int>> &p_indice, vecto
     }
 }
 
-// Hybrid Memetic Search (HMA)
-void search_framework(Data &data, Solution &best_s, int level, clock_t stime0, double update_value)
+// Steady-state memetic search: every worker repeatedly selects parents, builds and improves
+// a child and inserts it on its own, so no worker waits for the slowest child of a generation.
+// p_size inserted children count as one generation for termination and logging.
+// Returns true if the time limit is exhausted
+bool steady_state_search(vector<Solution> &pop, vector<double> &pop_fit, vector<int> &pop_argrank, Solution &best_s, const Data &data, SearchContext &ctx, int run, int &gen, int &no_improve, clock_t stime, int level, clock_t stime0, double &update_value)
+{
+    int len = data.p_size;
+    // a worker only locks the members it copies or replaces, one at a time, such that replacements of
+    // different members do not wait for each other. batch_mutex guards the parents handed out, rng, the
+    // best solution of ctx and the counters below, it is taken before member locks, never after one
+    vector<std::mutex> member(len); // member[i] guards pop[i] and pop_fit[i]
+    std::mutex batch_mutex;
+    vector<tuple<int, int>> p_indice(len);
+    int next_pair = len;    // parent pairs are handed out one by one from a batch of select_parents
+    int children = 0;
+    std::atomic<bool> stop(termination(no_improve, data));
+    bool time_exhausted = false;
+    double cost_in_this_run = pop_fit[pop_argrank[0]];
+
+    // fitness of a member, and the fitness of all members one by one
+    auto fit_of = [&](int i) {
+        std::lock_guard<std::mutex> lock(member[i]);
+        return pop_fit[i];
+    };
+    auto fits = [&]() {
+        vector<double> f(len);
+        for (int i = 0; i < len; i++) f[i] = fit_of(i);
+        return f;
+    };
+
+    // worker 0 searches with ctx itself, the others with the helpers of ctx. Parents and the seeds of
+    // the workers are drawn from rng, as worker 0 draws from the rng of ctx meanwhile
+    std::mt19937 rng = ctx.rng;
+    int n_workers = ctx.threads;
+    ctx.threads = 1;
+    vector<SearchContext *> workers = ctx.workers(n_workers, data);
+    RouteProximity start = ctx.proximity;
+    parallel_for(n_workers, n_workers, [&](int w, int) {
+        SearchContext &worker = *workers[w];
+        Solution p_1, p_2, ch;
+        ch.reserve(data);
+        while (true)
+        {
+            int p_1_indice, first, second;
+            {
+                std::lock_guard<std::mutex> lock(batch_mutex);
+                if (stop) break;
+                if (next_pair == len)
+                {
+                    select_parents(pop, fits(), p_indice, data, rng);
+                    next_pair = 0;
+                }
+                auto &index_t = p_indice[next_pair++];
+                p_1_indice = get<0>(index_t);
+                first = get<0>(index_t);
+                second = get<1>(index_t);
+                if (randint(0, 1, rng) != 0) std::swap(first, second);
+                worker.rng.seed(rng());
+            }
+            {
+                std::lock_guard<std::mutex> lock(member[first]);
+                p_1 = pop[first];
+            }
+            {
+                std::lock_guard<std::mutex> lock(member[second]);
+                p_2 = pop[second];
+            }
+            ch.clear(data);
+            double ch_fit;
+            crossover(p_1, p_2, ch, ch_fit, data, worker);
+            if (rand(0, 1, worker.rng) < data.ls_prob)
+                do_local_search(ch, data, worker);   // perform CDNS
+
+            if (stop) break;
+            if (data.replacement == ONE_ON_ONE)
+            {
+                std::lock_guard<std::mutex> lock(member[p_1_indice]);
+                if (ch.cost - pop_fit[p_1_indice] < -PRECISION)
+                {
+                    pop[p_1_indice] = ch;
+                    pop_fit[p_1_indice] = ch.cost;
+                }
+            }
+            else if (data.replacement == ELITISM_1)
+            {
+                // the child replaces the worst individual, the best one always survives. The worst
+                // is checked again once locked, another worker may have replaced it meanwhile
+                vector<double> f = fits();
+                int worst = int(std::max_element(f.begin(), f.end()) - f.begin());
+                std::lock_guard<std::mutex> lock(member[worst]);
+                if (ch.cost - pop_fit[worst] < -PRECISION)
+                {
+                    pop[worst] = ch;
+                    pop_fit[worst] = ch.cost;
+                }
+            }
+            else
+            {
+                /* more replacement */
+            }
+
+            std::lock_guard<std::mutex> lock(batch_mutex);
+            if (stop) break;
+            if (++children % len != 0) continue;
+            // a generation is done: the best and the output are taken with every member locked
+            for (auto &m : member) m.lock();
+            argsort(pop_fit, pop_argrank, len);
+            gen++;
+            no_improve++;
+            clock_t used = (wall_clock() - stime) / CLOCKS_PER_SEC;
+            update_best_solution(pop[pop_argrank[0]], best_s, used, run, gen, data, ctx, level, stime0, update_value);
+            if (pop_fit[pop_argrank[0]] - cost_in_this_run < -PRECISION)
+            {
+                no_improve = 0;
+                cost_in_this_run = pop_fit[pop_argrank[0]];
+            }
+
+            double used_sec = (wall_clock() - stime) / (CLOCKS_PER_SEC*1.0);
+            if (gen % OUTPUT_PER_GENS == 0)
+            {
+                printf("Gen: %d. ", gen);
+                output(pop, pop_fit, pop_argrank, data);
+                printf("Gen %d done, no improvement for %d gens, already consumed %.2lf sec\n", gen, no_improve, used_sec);
+            }
+            for (auto &m : member) m.unlock();
+            if (worker.deadline.expired())
+            {
+                time_exhausted = true;
+                stop = true;
+            }
+            if (termination(no_improve, data)) stop = true;
+        }
+    });
+    ctx.threads = n_workers;
+    ctx.rng = rng;
+    argsort(pop_fit, pop_argrank, len);
+    // worker 0 learned route gaps in ctx, take in what the others learned
+    for (int w = 1; w < n_workers; w++) ctx.proximity.merge(start, workers[w]->proximity);
+    return time_exhausted;
+}
+
+// island model: send the best individual to the next island and take in a migrant better than the worst individual
+void migrate(vector<Solution> &pop, vector<double> &pop_fit, vector<int> &pop_argrank, SearchContext &ctx)
 {
-    double cost_all_run = 0.0; 
-    double time_all_run = 0.0;
-    vector<double> solutions;
-    vector<double> times;
+    int len = int(pop.size());
+    ctx.ring->send(ctx.island, pop[pop_argrank[0]]);
+    Solution migrant;
+    if (!ctx.ring->receive(ctx.island, migrant)) return;
+    int worst = pop_argrank[len-1];
+    if (migrant.cost - pop_fit[worst] < -PRECISION)
+    {
+        printf("Island %d takes in a migrant: %.4f\n", ctx.island, migrant.cost);
+        pop[worst] = migrant;
+        pop_fit[worst] = migrant.cost;
+        argsort(pop_fit, pop_argrank, len);
+    }
+}
 
+// Hybrid Memetic Search (HMA)
+void search_framework(const Data &data, SearchContext &ctx, Solution &best_s, int level, clock_t stime0, double update_value)
+{
     vector<Solution> individual(1);
     vector<Solution> pop(data.p_size);
     vector<Solution> child(data.p_size);
@@ -640,10 +897,12 @@ void search_framework(Data &data, Solution &best_s, int level, clock_t stime0, d
 
     /* main body */
     bool time_exhausted = false;
-    int run = 1;
-    for (; run <= data.runs; run++)
+    int run = ctx.first_run;
+    if (level == 1 && ctx.resume != nullptr) run = ctx.resume->run;
+    for (; run <= ctx.last_run; run++)
     { 
-        clock_t stime = clock();
+        clock_t stime = wall_clock();
+        if (level == 1) ctx.deadline = Deadline(stime, data.tmax);
         clock_t used = 0;
         double used_sec = 0.0;
         int no_improve = 0;
@@ -654,85 +913,135 @@ void search_framework(Data &data, Solution &best_s, int level, clock_t stime0, d
                 printf("---------------------------------Run %d---------------------------\n", run);
 
 
-                // construct a init solution
-                initialization(individual, individual_fit, individual_argrank, data);
-                used_sec = (clock() - stime) / (CLOCKS_PER_SEC*1.0);
-                printf("already consumed %.2lf sec\n", used_sec); 
-                local_search(individual, individual_fit, individual_argrank, data);
-                used_sec = (clock() - stime) / (CLOCKS_PER_SEC*1.0);
-                printf("already consumed %.2lf sec\n", used_sec);  
-                printf("After local search\n");
-                output(individual, individual_fit, individual_argrank, data);
-                
+                double cost_in_this_run;
+                clock_t phase_start;
+                if (ctx.resume != nullptr)
+                {
+                    // continue the checkpointed gen loop, the time it consumed counts against data.tmax
+                    SearchState &state = *ctx.resume;
+                    individual[0] = state.individual;
+                    individual_fit[0] = state.individual_fit;
+                    individual_argrank[0] = 0;
+                    gen = state.gen;
+                    no_improve = state.no_improve;
+                    cost_in_this_run = state.cost_in_this_run;
+                    stime -= clock_t(state.used_sec * CLOCKS_PER_SEC);
+                    ctx.deadline = Deadline(stime, data.tmax);
+                    ctx.resume = nullptr;
+                    printf("Resume at gen %d, already consumed %.2lf sec\n", gen, state.used_sec);
+                }
+                else
+                {
+                    ctx.phases.reset();
+                    phase_start = wall_clock();
+
+                    // construct a init solution
+                    initialization(individual, individual_fit, individual_argrank, data, ctx);
+                    used_sec = (wall_clock() - stime) / (CLOCKS_PER_SEC*1.0);
+                    printf("already consumed %.2lf sec\n", used_sec); 
+                    local_search(individual, individual_fit, individual_argrank, data, ctx);
+                    used_sec = (wall_clock() - stime) / (CLOCKS_PER_SEC*1.0);
+                    printf("already consumed %.2lf sec\n", used_sec);  
+                    printf("After local search\n");
+                    output(individual, individual_fit, individual_argrank, data);
+                    ctx.phases.add(CONSTRUCTION, phase_start, 0.0);
+                    cost_in_this_run = individual_fit[0];
+                }
 
-                double cost_in_this_run = individual_fit[0];
+                // the phases are either run as below, or one phase per gen chosen by the schedule
+                bool scheduled = !data.phase_time.empty() || data.adaptive_phases;
                 while (!termination(no_improve, data))
                 {
                     gen++;
                     no_improve++;
                    
                     // individual S is not improved in the last G iterations
-                    if ((data.population_search && !data.individual_search) || (data.population_search && data.individual_search && termination(no_improve, data))){  
+                    bool decomposition = (data.population_search && !data.individual_search) || (data.population_search && data.individual_search && termination(no_improve, data));
+                    bool cdns = decomposition;
+                    bool lns = true;
+                    if (scheduled)
+                    {
+                        int phase = ctx.phases.next(data, gen);
+                        decomposition = (phase == DECOMPOSITION);
+                        cdns = (phase == CDNS);
+                        lns = (phase == LNS);
+                    }
+                    double phase_cost = individual_fit[0];
+                    phase_start = wall_clock();
+
+                    if (decomposition){  
 
                             // Decomposition Strategy
-                            decomposition_cluster(individual, individual_fit, individual_argrank, data, stime);                           
-                            used_sec = (clock() - stime) / (CLOCKS_PER_SEC*1.0);
+                            decomposition_cluster(individual, individual_fit, individual_argrank, data, ctx, stime);                           
+                            used_sec = (wall_clock() - stime) / (CLOCKS_PER_SEC*1.0);
                             printf("Decomposition done, already consumed %.2lf sec\n", used_sec);
+                            ctx.phases.add(DECOMPOSITION, phase_start, phase_cost - individual_fit[0]);
 
-                            // used = (clock() - stime) / CLOCKS_PER_SEC;
-                            // update_best_solution(individual[0], best_s, used, run, gen, data, level, stime0, update_value);
+                            // used = (wall_clock() - stime) / CLOCKS_PER_SEC;
+                            // update_best_solution(individual[0], best_s, used, run, gen, data, ctx, level, stime0, update_value);
 
                             printf("After decomposition\n");
                             output(individual, individual_fit, individual_argrank, data);
 
                             //-----------------------------------------------------------------------------------------------
-                            used_sec = (clock() - stime) / (CLOCKS_PER_SEC*1.0);
+                            used_sec = (wall_clock() - stime) / (CLOCKS_PER_SEC*1.0);
                             printf("already consumed %.2lf sec\n", used_sec);  
 
-                            used = (clock() - stime) / CLOCKS_PER_SEC;
-                            update_best_solution(individual[0], best_s, used, run, gen, data, level, stime0, update_value);
+                            used = (wall_clock() - stime) / CLOCKS_PER_SEC;
+                            update_best_solution(individual[0], best_s, used, run, gen, data, ctx, level, stime0, update_value);
                 
-                            if (data.tmax != NO_LIMIT && used_sec > clock_t(data.tmax))
+                            if (ctx.deadline.expired())
                             {
                                 time_exhausted = true;
                                 break;
                             }
                             //-----------------------------------------------------------------------------------------------
-
-                            local_search(individual, individual_fit, individual_argrank, data);
-                            used_sec = (clock() - stime) / (CLOCKS_PER_SEC*1.0);
+                    }
+                    if (cdns){
+                            phase_cost = individual_fit[0];
+                            phase_start = wall_clock();
+                            local_search(individual, individual_fit, individual_argrank, data, ctx);
+                            used_sec = (wall_clock() - stime) / (CLOCKS_PER_SEC*1.0);
                             printf("already consumed %.2lf sec\n", used_sec);  
+                            ctx.phases.add(CDNS, phase_start, phase_cost - individual_fit[0]);
                             
                             printf("After local search\n");
                             output(individual, individual_fit, individual_argrank, data);
 
                             //-----------------------------------------------------------------------------------------------
-                            used_sec = (clock() - stime) / (CLOCKS_PER_SEC*1.0);
+                            used_sec = (wall_clock() - stime) / (CLOCKS_PER_SEC*1.0);
                             printf("already consumed %.2lf sec\n", used_sec);  
 
-                            used = (clock() - stime) / CLOCKS_PER_SEC;
-                            update_best_solution(individual[0], best_s, used, run, gen, data, level, stime0, update_value);
+                            used = (wall_clock() - stime) / CLOCKS_PER_SEC;
+                            update_best_solution(individual[0], best_s, used, run, gen, data, ctx, level, stime0, update_value);
                 
-                            if (data.tmax != NO_LIMIT && used_sec > clock_t(data.tmax))
+                            if (ctx.deadline.expired())
                             {
                                 time_exhausted = true;
                                 break;
                             }
-                            if (data.population_search && !data.individual_search) break; 
+                            if (!scheduled && data.population_search && !data.individual_search) break; 
                             //-----------------------------------------------------------------------------------------------
                     }
 
-                    
-                    large_neighbourhood_search(individual, individual_fit, individual_argrank, data);
+                    if (lns){
+                            phase_cost = individual_fit[0];
+                            phase_start = wall_clock();
+                            large_neighbourhood_search(individual, individual_fit, individual_argrank, data, ctx);
 
-                    used_sec = (clock() - stime) / (CLOCKS_PER_SEC*1.0);
-                    printf("already consumed %.2lf sec\n", used_sec);  
+                            used_sec = (wall_clock() - stime) / (CLOCKS_PER_SEC*1.0);
+                            printf("already consumed %.2lf sec\n", used_sec);  
+                            ctx.phases.add(LNS, phase_start, phase_cost - individual_fit[0]);
 
-                    used = (clock() - stime) / CLOCKS_PER_SEC;
-                    update_best_solution(individual[0], best_s, used, run, gen, data, level, stime0, update_value);
+                            used = (wall_clock() - stime) / CLOCKS_PER_SEC;
+                            update_best_solution(individual[0], best_s, used, run, gen, data, ctx, level, stime0, update_value);
 
-                    printf("After large neighbourhood search\n");
-                    output(individual, individual_fit, individual_argrank, data);
+                            printf("After large neighbourhood search\n");
+                            output(individual, individual_fit, individual_argrank, data);
+                    }
+
+                    if (ctx.ring != nullptr && gen % data.migration == 0)
+                        migrate(individual, individual_fit, individual_argrank, ctx);
 
                     if (individual_fit[0] - cost_in_this_run < -PRECISION)
                     {
@@ -740,81 +1049,103 @@ void search_framework(Data &data, Solution &best_s, int level, clock_t stime0, d
                             cost_in_this_run = individual_fit[0];
                     }
 
-                    used_sec = (clock() - stime) / (CLOCKS_PER_SEC*1.0);
-                    used = (clock() - stime) / CLOCKS_PER_SEC;
+                    used_sec = (wall_clock() - stime) / (CLOCKS_PER_SEC*1.0);
+                    used = (wall_clock() - stime) / CLOCKS_PER_SEC;
 
                     if (gen % OUTPUT_PER_GENS == 0)
                     {
                         printf("Gen %d done, no improvement for %d gens, already consumed %.2lf sec\n", gen, no_improve, used_sec);
+                        if (scheduled) ctx.phases.output();
                     }
                     // printf("-----------------------------------------------------------------\n");
 
-                    if (data.tmax != NO_LIMIT && used_sec > clock_t(data.tmax))
+                    if (ctx.deadline.expired())
                     {
                         time_exhausted = true;
                         break;
                     }
+
+                    if (ctx.checkpointer != nullptr)
+                    {
+                        SearchState state;
+                        state.run = run;
+                        state.gen = gen;
+                        state.no_improve = no_improve;
+                        state.cost_in_this_run = cost_in_this_run;
+                        state.used_sec = (wall_clock() - stime) / (CLOCKS_PER_SEC*1.0);
+                        state.individual = individual[0];
+                        state.individual_fit = individual_fit[0];
+                        ctx.checkpointer->snapshot(state, data, ctx);
+                    }
                 }              
 
-                printf("Run %d finishes\n", run);
-                cost_all_run += individual_fit[0];
-                time_all_run += used_sec;
+                // the latest checkpoint is of the last gen completed before the signal, main reports
+                // the best solution so far and writes it once every search has returned
+                if (interrupted) return;
 
-                solutions.push_back(individual_fit[0]);
-                times.push_back(used_sec);
+                printf("Run %d finishes\n", run);
+                ctx.phases.output();
+                ctx.run_costs.push_back(individual_fit[0]);
+                ctx.run_times.push_back(used_sec);
 
                 output(individual, individual_fit, individual_argrank, data);
-                data.rng.seed(data.seed + run);
+                ctx.rng.seed(ctx.seed + run);
                 // if (time_exhausted) {run++; break;}   
 
         }
         else{   // population-based search
                 
                 stime = stime0;
+                ctx.deadline.limit(Deadline(stime, data.tmax));
                 
                 // population initialization
-                initialization(pop, pop_fit, pop_argrank, data);
-                used_sec = (clock() - stime) / (CLOCKS_PER_SEC*1.0);
+                initialization(pop, pop_fit, pop_argrank, data, ctx);
+                used_sec = (wall_clock() - stime) / (CLOCKS_PER_SEC*1.0);
                 printf("already consumed %.2lf sec\n", used_sec); 
-                local_search(pop, pop_fit, pop_argrank, data);
-                used_sec = (clock() - stime) / (CLOCKS_PER_SEC*1.0);
+                local_search(pop, pop_fit, pop_argrank, data, ctx);
+                used_sec = (wall_clock() - stime) / (CLOCKS_PER_SEC*1.0);
                 printf("already consumed %.2lf sec\n", used_sec);    
                 printf("After local search\n");
                 output(pop, pop_fit, pop_argrank, data);
 
                 // enters an evolutionary process
                 double cost_in_this_run = pop_fit[pop_argrank[0]];
-                while (!termination(no_improve, data))
+                if (data.steady_state)
+                {
+                    time_exhausted = steady_state_search(pop, pop_fit, pop_argrank, best_s, data, ctx, run, gen, no_improve, stime, level, stime0, update_value);
+                    used_sec = (wall_clock() - stime) / (CLOCKS_PER_SEC*1.0);
+                }
+                while (!data.steady_state && !termination(no_improve, data))
                 {
                     gen++;
                     // printf("---------------------------------Gen %d---------------------------\n", gen);
                     no_improve++;
                     // select parents
-                    select_parents(pop, pop_fit, p_indice, data);
+                    select_parents(pop, pop_fit, p_indice, data, ctx.rng);
                     // crossover
-                    crossover(pop, data, p_indice, child, child_fit);
+                    crossover(pop, data, ctx, p_indice, child, child_fit);
 
-                    used_sec = (clock() - stime) / (CLOCKS_PER_SEC*1.0);
+                    used_sec = (wall_clock() - stime) / (CLOCKS_PER_SEC*1.0);
                     printf("already consumed %.2lf sec\n", used_sec);
 
                     // do local search for children
-                    local_search(child, child_fit, child_argrank, data);
+                    local_search(child, child_fit, child_argrank, data, ctx);
 
                     // replacement
                     replacement(pop, p_indice, child, pop_fit, pop_argrank, child_fit, child_argrank, data);
                     // update best
                     argsort(pop_fit, pop_argrank, data.p_size);
 
-                    used = (clock() - stime) / CLOCKS_PER_SEC;
-                    update_best_solution(pop[pop_argrank[0]], best_s, used, run, gen, data, level, stime0, update_value);
+                    used = (wall_clock() - stime) / CLOCKS_PER_SEC;
+                    update_best_solution(pop[pop_argrank[0]], best_s, used, run, gen, data, ctx, level, stime0, update_value);
                     if (pop_fit[pop_argrank[0]] - cost_in_this_run < -PRECISION)
                     {
                         no_improve = 0;
                         cost_in_this_run = pop_fit[pop_argrank[0]];
                     }
 
-                    used_sec = (clock() - stime) / (CLOCKS_PER_SEC*1.0);
-                    used = (clock() - stime) / CLOCKS_PER_SEC;
+                    used_sec = (wall_clock() - stime) / (CLOCKS_PER_SEC*1.0);
+                    used = (wall_clock() - stime) / CLOCKS_PER_SEC;
 
                     if (gen % OUTPUT_PER_GENS == 0)
                     {
@@ -823,7 +1154,7 @@ void search_framework(Data &data, Solution &best_s, int level, clock_t stime0, d
                         printf("Gen %d done, no improvement for %d gens, already consumed %.2lf sec\n", gen, no_improve, used_sec);
                     }
 
-                    if (data.tmax != NO_LIMIT && used_sec > clock_t(data.tmax))
+                    if (ctx.deadline.expired())
                     {
                         time_exhausted = true;
                         break;
@@ -831,94 +1162,163 @@ void search_framework(Data &data, Solution &best_s, int level, clock_t stime0, d
                 }
 
                 printf("Run %d finishes\n", run);
-                cost_all_run += pop_fit[pop_argrank[0]];
-                time_all_run += used_sec;
                 output(pop, pop_fit, pop_argrank, data);
-                data.rng.seed(data.seed + run);
+                ctx.rng.seed(ctx.seed + run);
                 // if (time_exhausted) {run++; break;}
             }
     }
 
     // output best solution
-    if (level != 0) {
+    if (level != 0 && ctx.shared == nullptr) output_best_solution(best_s, data, ctx);
+}
 
-        printf("------------Summary-----------\n");
-        if (BENCHMARKING_O_1_EVAL)
+// searches sharing one Data: the runs start together with data.parallel_runs, and every run
+// is done by data.islands searches with their own seeds on a ring, each on its own thread.
+// ctx only keeps the best solution of all searches and the result of every run
+void concurrent_search(const Data &data, SearchContext &ctx)
+{
+    SharedBest shared(ctx);
+    int islands = data.islands;
+    int concurrent_runs = data.parallel_runs ? data.runs : 1;
+    int threads = std::max(1, ctx.threads / (concurrent_runs * islands));
+    vector<double> run_costs(data.runs), run_times(data.runs);
+    parallel_for(data.runs, concurrent_runs, [&](int r, int) {
+        int run = r + 1;
+        IslandRing ring(islands);
+        vector<SearchContext> island;
+        island.reserve(islands);
+        for (int i = 0; i < islands; i++)
         {
-            printf("Number of move eval calls: %d, average time: %d nanosecs\n", call_count_move_eval, mean_duration_move_eval);
-        }
-        best_s.output(data);
-        if (!best_s.check(data)) exit(0);  // check if feasible, then save best solution and run time in file
-        printf("Total %d runs, total consumed %.2lf sec\n", run-1, time_all_run);
-        
-        std::string timelimit = std::to_string(data.tmax);
-        std::string subproblem_range = std::to_string(data.subproblem_range);
-        std::string filename = data.output + data.problem_name + "_timelimit=" + timelimit + "_subproblem=" +  subproblem_range + ".txt";
-        FILE *file_solution = fopen(filename.c_str(), "a");
-        if (file_solution == nullptr) {
-            perror("Failed to open file");
+            island.emplace_back(data);
+            // island 0 searches as the sequential run would, the others use seeds no other run uses
+            island[i].seed = data.seed + i * data.runs;
+            island[i].rng.seed(island[i].seed + run - 1);
+            island[i].threads = threads;
+            island[i].first_run = island[i].last_run = run;
+            island[i].shared = &shared;
+            if (islands > 1) island[i].ring = &ring;
+            island[i].island = i;
         }
-        std::string output_s = "Details of the solution:\n";
-        int len = best_s.len();
-        for (int i = 0; i < len; i++)
+        parallel_for(islands, islands, [&](int i, int) {
+            search_framework(data, island[i], island[i].best_s, 1, -1, -1);
+        });
+        // an interrupted island returns before recording its run
+        if (interrupted) return;
+        // a run costs as much as its best island and lasts as long as its slowest island
+        run_costs[r] = double(INFINITY);
+        run_times[r] = 0.0;
+        for (auto &search : island)
         {
-            Route &r=best_s.get(i);
-            int flag = 0;
-            double new_cost = 0.0;
-            int index_negtive_first = -1;
-            std::vector<int> &nl = r.node_list;
-            output_s += "route " + std::to_string(i) +
-                        ", node_num " + std::to_string(nl.size()) +
-                        ", cost " + std::to_string(r.transcost) +
-                        ", nodes:";
-            update_route_status(nl, r.status_list, data, flag, new_cost, index_negtive_first); 
-            int pre = -1;            
-            for (int j = 0; j < nl.size(); j++)
-            {  
-                int node = nl[j];
-                if (pre != -1){
-                    for (int sub_node: data.hyperarc[pre][node]){
-                          output_s += ' ' + std::to_string(sub_node);
-                    }
-                }
-                output_s += ' ' + std::to_string(node);
-                if (data.node[node].type != 1){
-                    std::ostringstream stream1;
-                    std::ostringstream stream2;
-                    stream1 << std::fixed << std::setprecision(2) << r.status_list[j].arr_RD;
-                    stream2 << std::fixed << std::setprecision(2) << r.status_list[j].dep_RD;
-                    std::string Str1 = stream1.str();
-                    std::string Str2 = stream2.str();
-                    output_s += "(" + Str1 + ", "+ Str2 + ")";
+            run_costs[r] = std::min(run_costs[r], search.run_costs[0]);
+            run_times[r] = std::max(run_times[r], search.run_times[0]);
+        }
+    });
+    if (interrupted) return;
+    ctx.run_costs = run_costs;
+    ctx.run_times = run_times;
+    output_best_solution(ctx.best_s, data, ctx);
+}
 
+void output_best_solution(Solution &best_s, const Data &data, SearchContext &ctx)
+{
+    int runs = int(ctx.run_costs.size());
+    double cost_all_run = std::accumulate(ctx.run_costs.begin(), ctx.run_costs.end(), 0.0);
+    double time_all_run = std::accumulate(ctx.run_times.begin(), ctx.run_times.end(), 0.0);
+
+    printf("------------Summary-----------\n");
+    if (BENCHMARKING_O_1_EVAL)
+    {
+        printf("Number of move eval calls: %ld, average time: %.2f nanosecs\n", ctx.call_count_move_eval, ctx.mean_duration_move_eval);
+    }
+    best_s.output(data);
+    if (!best_s.check(data)) exit(0);  // check if feasible, then save best solution and run time in file
+    printf("Total %d runs, total consumed %.2lf sec\n", runs, time_all_run);
+    if (data.granular > 0)
+    {
+        long checked, skipped;
+        granular_stats(checked, skipped);
+        printf("Granular neighbourhoods skipped %ld of %ld inter-route moves (%.2f%%)\n", skipped, checked, checked ? 100.0 * skipped / checked : 0.0);
+    }
+    if (data.route_proximity)
+    {
+        long checked, skipped;
+        route_proximity_stats(checked, skipped);
+        printf("Route proximity filter skipped %ld of %ld route pairs (%.2f%%)\n", skipped, checked, checked ? 100.0 * skipped / checked : 0.0);
+    }
+    if (data.dirty_routes)
+    {
+        long listed, reused, routes, clean;
+        dirty_route_stats(listed, reused, routes, clean);
+        printf("Dirty route tracking skipped %ld of %ld sub-neighborhoods (%.2f%%), %ld of %ld routes entered CDNS clean (%.2f%%)\n",
+               reused, listed, listed ? 100.0 * reused / listed : 0.0, clean, routes, routes ? 100.0 * clean / routes : 0.0);
+    }
+    
+    std::string timelimit = std::to_string(data.tmax);
+    std::string subproblem_range = std::to_string(data.subproblem_range);
+    std::string filename = data.output + data.problem_name + "_timelimit=" + timelimit + "_subproblem=" +  subproblem_range + ".txt";
+    FILE *file_solution = fopen(filename.c_str(), "a");
+    if (file_solution == nullptr) {
+        perror("Failed to open file");
+    }
+    std::string output_s = "Details of the solution:\n";
+    int len = best_s.len();
+    for (int i = 0; i < len; i++)
+    {
+        Route &r=best_s.get(i);
+        int flag = 0;
+        double new_cost = 0.0;
+        int index_negtive_first = -1;
+        std::vector<int> &nl = r.node_list;
+        output_s += "route " + std::to_string(i) +
+                    ", node_num " + std::to_string(nl.size()) +
+                    ", cost " + std::to_string(r.transcost) +
+                    ", nodes:";
+        update_route_status(nl, r.status_list, data, flag, new_cost, index_negtive_first); 
+        int pre = -1;            
+        for (int j = 0; j < nl.size(); j++)
+        {  
+            int node = nl[j];
+            if (pre != -1){
+                for (int sub_node: data.hyperarc[pre][node]){
+                      output_s += ' ' + std::to_string(sub_node);
                 }
-                pre = node;
             }
-            output_s += '\n';
-        }
-        output_s += "vehicle (route) number: " + std::to_string(len) + '\n';
-
-        std::ostringstream stream;
-        
-        stream << std::fixed << std::setprecision(2) << best_s.cost;
-        std::string costStr = stream.str();
-
-        output_s += "Total cost: " + costStr + '\n';
-        const char* c_output_s = output_s.c_str();
-        fprintf(file_solution, "%s", c_output_s);
-        for (int i = 0; i < run - 1; i++){
-            fprintf(file_solution, "%.2lf, %.2lf\n", solutions[i], times[i]);
-        }
-        fclose(file_solution);
-       
-        std::string filename_output = data.output +"output_1.txt";
-        FILE *file = fopen(filename_output.c_str(), "a");
-        if (file == nullptr) {
-            perror("Failed to open file");
+            output_s += ' ' + std::to_string(node);
+            if (data.node[node].type != 1){
+                std::ostringstream stream1;
+                std::ostringstream stream2;
+                stream1 << std::fixed << std::setprecision(2) << r.status_list[j].arr_RD;
+                stream2 << std::fixed << std::setprecision(2) << r.status_list[j].dep_RD;
+                std::string Str1 = stream1.str();
+                std::string Str2 = stream2.str();
+                output_s += "(" + Str1 + ", "+ Str2 + ")";
+
+            }
+            pre = node;
         }
-        const char* c_str = data.problem_name.c_str();
-        fprintf(file, "%s: %d, %.2lf, %.2lf, %.2lf, subproblem = %d, timelimit = %d\n", c_str, best_s.len(), best_s.cost, cost_all_run / (run-1), time_all_run / (run-1), data.subproblem_range, data.tmax);
-        fclose(file);
+        output_s += '\n';
     }
+    output_s += "vehicle (route) number: " + std::to_string(len) + '\n';
 
-}
\ No newline at end of file
+    std::ostringstream stream;
+    
+    stream << std::fixed << std::setprecision(2) << best_s.cost;
+    std::string costStr = stream.str();
+
+    output_s += "Total cost: " + costStr + '\n';
+    const char* c_output_s = output_s.c_str();
+    fprintf(file_solution, "%s", c_output_s);
+    for (int i = 0; i < runs; i++){
+        fprintf(file_solution, "%.2lf, %.2lf\n", ctx.run_costs[i], ctx.run_times[i]);
+    }
+    fclose(file_solution);
+   
+    std::string filename_output = data.output +"output_1.txt";
+    FILE *file = fopen(filename_output.c_str(), "a");
+    if (file == nullptr) {
+        perror("Failed to open file");
+    }
+    const char* c_str = data.problem_name.c_str();
+    fprintf(file, "%s: %d, %.2lf, %.2lf, %.2lf, subproblem = %d, timelimit = %d\n", c_str, best_s.len(), best_s.cost, cost_all_run / runs, time_all_run / runs, data.subproblem_range, data.tmax);
+    fclose(file);
+}
@@ -20,11 +20,13 @@ framework for further automatic algorithm design
 #include "config.h"
 using namespace std;
 
-void search_framework(Data &data, Solution &s, int level, clock_t stime0, double update_value);
-void decomposition_cluster(vector<Solution> &pop, vector<double> &pop_fit, vector<int> &pop_argrank, Data &data, clock_t stime);
-void initialization(vector<Solution> &pop, vector<double> &pop_fit, vector<int> &pop_argrank, Data &data);
+void search_framework(const Data &data, SearchContext &ctx, Solution &s, int level, clock_t stime0, double update_value);
+void concurrent_search(const Data &data, SearchContext &ctx);
+void output_best_solution(Solution &best_s, const Data &data, SearchContext &ctx);
+void decomposition_cluster(vector<Solution> &pop, vector<double> &pop_fit, vector<int> &pop_argrank, const Data &data, SearchContext &ctx, clock_t stime);
+void initialization(vector<Solution> &pop, vector<double> &pop_fit, vector<int> &pop_argrank, const Data &data, SearchContext &ctx);
 
-static inline bool termination(int no_improve, Data &data)
+static inline bool termination(int no_improve, const Data &data)
 {
     return (no_improve > data.g_1);
 }
@@ -1,6 +1,6 @@
 #include "solution.h"
 
-void attr_for_one_node(Data &data, int node, Attr &a)
+void attr_for_one_node(const Data &data, int node, Attr &a)
 {
     a.s = node;
     a.e = node;
@@ -31,7 +31,7 @@ void attr_for_one_node(Data &data, int node, Attr &a)
     }
 }
 
-Attr attr_for_one_node(Data &data, int node)
+Attr attr_for_one_node(const Data &data, int node)
 {
     Attr a;
     attr_for_one_node(data, node, a);
@@ -88,7 +88,7 @@ void connect(Attr &merged_attr, const Attr &tmp_b, double dist_ij, double t_ij)
     merged_attr.e = tmp_b.e;
 }
 
-std::vector<int> make_tmp_nl(Data &data)
+std::vector<int> make_tmp_nl(const Data &data)
 {
     std::vector<int> nl(2, data.DC);
     return nl;
@@ -2,6 +2,9 @@
 #include <iostream>
 #include <cstdio>
 #include <vector>
+#include <memory>
+#include <utility>
+#include <atomic>
 #include <unordered_set>
 #include <iostream>
 #include <iomanip>
@@ -31,8 +34,8 @@ struct Attr
     double C_L; // the final capacity demand
 };
 
-void attr_for_one_node(Data &data, int node, Attr &a);
-Attr attr_for_one_node(Data &data, int node);
+void attr_for_one_node(const Data &data, int node, Attr &a);
+Attr attr_for_one_node(const Data &data, int node);
 
 // connect tmp_a and tmp_b, return value
 Attr connect(const Attr &tmp_a, const Attr &tmp_b, double dist_ij, double t_ij);
@@ -41,10 +44,21 @@ Attr connect(const Attr &tmp_a, const Attr &tmp_b, double dist_ij, double t_ij);
 void connect(const Attr &tmp_a, const Attr &tmp_b, Attr &merged_attr, double dist_ij, double t_ij);
 void connect(Attr &merged_attr, const Attr &tmp_b, double dist_ij, double t_ij);
 
-std::vector<int> make_tmp_nl(Data &data);
+std::vector<int> make_tmp_nl(const Data &data);
 
 bool equal_attr(const Attr &a, const Attr &b);
 
+// FNV-1a hash of a node list, continuing from h
+inline unsigned long long hash_nodes(const std::vector<int> &nl, unsigned long long h = 14695981039346656037ULL)
+{
+    for (int node : nl)
+    {
+        h ^= (unsigned long long)(unsigned int)node;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
 /* route class definition */
 class Route
 {
@@ -55,23 +69,21 @@ public:
     std::vector<status> status_list;   //arr_time, dep_time, arr_RD, dep_RD
     double dep_time, ret_time, transcost, total_cost, x, y;
     int node_num, customer_num, cluster;  //the customer number in route
-    std::vector<Attr> attr;
+    double min_x, max_x, min_y, max_y; // bounding box of the customers
+    double tw_start, tw_end; // earliest start and latest end of the time windows of the customers
+    unsigned long long cdns_version = 0; // version() when CDNS last returned the route, it is clean while they match (--dirty_routes)
+    std::vector<Attr, PoolAllocator<Attr>> attr; // n x n for a route of n nodes
     Attr self;
     
     Route() {}
 
-    Route(Data &data)
+    // storage is sized to the route, update_route_status grows status_list to the node lists it evaluates
+    Route(const Data &data)
     {
-        this->attr.reserve(MAX_NODE_IN_ROUTE * MAX_NODE_IN_ROUTE);
-        this->node_list.reserve(MAX_NODE_IN_ROUTE);
-        this->customer_list.reserve(MAX_NODE_IN_ROUTE);
-        this->temp_node_list.reserve(MAX_NODE_IN_ROUTE);
-        this->status_list.reserve(MAX_NODE_IN_ROUTE);
-
         this->node_list.push_back(data.DC);
         this->node_list.push_back(data.DC);
         
-        this->status_list.resize(MAX_NODE_IN_ROUTE);
+        this->status_list.resize(2);
         status start{data.start_time, data.start_time, data.max_distance_reachable, data.max_distance_reachable};
         this->status_list[0] = start;
 
@@ -85,8 +97,13 @@ public:
         int nl_len = int(node_list.size());
         return this->attr[i * nl_len + j];
     }
+    const Attr &gat(int i, int j) const
+    {
+        int nl_len = int(node_list.size());
+        return this->attr[i * nl_len + j];
+    }
 
-    void cal_attr(Data &data) //calculate complete attr matrix O(n^2)
+    void cal_attr(const Data &data) //calculate complete attr matrix O(n^2)
     {
         int nl_len = int(node_list.size());
         int end_index = nl_len - 1;
@@ -135,13 +152,32 @@ public:
     }
 
     // method used when applying move operator
-    void update(Data &data)
+    void update(const Data &data)
     {
         // update this route, including attribute (if necessary), dep_time and ret_time
         this->cal_attr(data);
         // set dep_time and ret_time
         this->dep_time = this->self.T_E;
         this->ret_time = this->dep_time + this->self.T_D;
+        this->update_extent(data);
+    }
+
+    // bounding box and time-window span of the customers, empty (min > max) for an empty route
+    void update_extent(const Data &data)
+    {
+        this->min_x = this->min_y = this->tw_start = double(INFINITY);
+        this->max_x = this->max_y = this->tw_end = -double(INFINITY);
+        for (int node : this->node_list)
+        {
+            auto &p = data.node[node];
+            if (p.type != 1) continue;
+            this->min_x = std::min(this->min_x, p.x);
+            this->max_x = std::max(this->max_x, p.x);
+            this->min_y = std::min(this->min_y, p.y);
+            this->max_y = std::max(this->max_y, p.y);
+            this->tw_start = std::min(this->tw_start, p.start);
+            this->tw_end = std::max(this->tw_end, p.end);
+        }
     }
 
     void set_node_list(const std::vector<int> &nl) 
@@ -150,7 +186,7 @@ public:
     }
 
     // cost
-    double cal_cost(Data &data)
+    double cal_cost(const Data &data)
     {
         this->transcost = this->self.dist * data.vehicle.unit_cost;
         double dispatchcost = 0.0;
@@ -159,13 +195,26 @@ public:
         return this->transcost + dispatchcost;
     }
 
+    // cost without updating transcost, safe to call on a route shared by threads
+    double peek_cost(const Data &data) const
+    {
+        double dispatchcost = 0.0;
+        if (this->self.num_cus != 0)
+            dispatchcost = data.vehicle.d_cost;
+        return this->self.dist * data.vehicle.unit_cost + dispatchcost;
+    }
+    // version of the node list, routes of the same version visit the same nodes in the same order
+    unsigned long long version() const
+    {
+        return hash_nodes(this->node_list);
+    }
     // others
-    bool isempty()
+    bool isempty() const
     {
         return this->self.num_cus == 0;
     }
 
-    std::vector<int> check(Data &data, bool &st_re_DC, bool &smaller_ca, bool &earlier_tw, bool &positive_ba, double &cost)
+    std::vector<int> check(const Data &data, bool &st_re_DC, bool &smaller_ca, bool &earlier_tw, bool &positive_ba, double &cost)
     {
         /*
         flag == 0 route error
@@ -186,6 +235,8 @@ public:
             st_re_DC = false;
             return nodes;
         }
+        if (int(sl.size()) < len) sl.resize(len);
+        sl[0] = status{data.start_time, data.start_time, data.max_distance_reachable, data.max_distance_reachable};
 
         double capacity = data.vehicle.capacity;
         double distance = 0.0;
@@ -347,58 +398,152 @@ public:
     }
 };
 
-/* solution class definition*/
+/* solution class definition. Routes are shared between copies of a solution (copy-on-write):
+copying a solution copies one pointer per route, get() clones a route shared with another copy
+before handing it out for modification, peek() reads a route without cloning it.
+locate() finds the route and position of a customer through an index built on its first call,
+copies start without one. get() marks the route it hands out for re-indexing at the next locate(),
+the index is thus kept up to date by any change of the solution. A position the index got wrong
+regardless, e.g. through a reference from get() kept across locate(), makes it rebuild the index.
+locate() writes the index, it is not for solutions read by other threads */
 class Solution
 {
 private:
-    std::vector<Route> route_list;
+    std::vector<std::shared_ptr<Route>> route_list;
+
+    // customer index: where[c] is the (route, position) customer c had when its route was last
+    // indexed, routes modified since then are flagged in is_stale and listed in stale.
+    // Empty where means no index
+    std::vector<std::pair<int, int>> where;
+    std::vector<char> is_stale;
+    std::vector<int> stale;
+
+    void drop_index()
+    {
+        this->where.clear();
+        this->is_stale.clear();
+        this->stale.clear();
+    }
+
+    // whether the index holds the current route and position of customer c
+    bool indexed_at(int c, int &route, int &pos) const
+    {
+        const std::pair<int, int> &w = this->where[c];
+        if (w.first < 0 || w.first >= this->len()) return false;
+        const std::vector<int> &nl = this->peek(w.first).node_list;
+        if (w.second >= int(nl.size()) || nl[w.second] != c) return false;
+        route = w.first;
+        pos = w.second;
+        return true;
+    }
+
+    void mark(int index)
+    {
+        if (this->where.empty() || this->is_stale[index]) return;
+        this->is_stale[index] = 1;
+        this->stale.push_back(index);
+    }
+
+    // routes from index on changed place
+    void mark_from(int index)
+    {
+        if (this->where.empty()) return;
+        int len = this->len();
+        this->is_stale.resize(len);
+        for (int r = index; r < len; r++)
+        {
+            this->is_stale[r] = 0;
+            this->mark(r);
+        }
+    }
+
+    // only a route this solution owns alone may be modified. use_count() is a relaxed load, the
+    // fence orders the reads of a thread that dropped the last other copy before our writes
+    Route &detach(std::shared_ptr<Route> &r)
+    {
+        if (r.use_count() > 1)
+            r = std::make_shared<Route>(*r);
+        else
+            std::atomic_thread_fence(std::memory_order_acquire);
+        return *r;
+    }
 
 public:
     double cost = 0.0;
 
     Solution(){}
 
-    Solution(Data &data)
+    Solution(const Data &data)
     { 
         this->route_list.reserve(data.vehicle.max_num);
     }
+
+    // copies share the routes but not the customer index, it is rebuilt by locate() if needed
+    Solution(const Solution &other) : route_list(other.route_list), cost(other.cost) {}
+    Solution(Solution &&other) = default;
+
+    Solution &operator=(const Solution &other)
+    {
+        if (this == &other) return *this;
+        this->route_list = other.route_list;
+        this->cost = other.cost;
+        this->drop_index();
+        return *this;
+    }
+    Solution &operator=(Solution &&other) = default;
     // Function to merge another Solution into this one
     void merge(const Solution& other)
     {
         // Append routes from other to this
+        int len = this->len();
         route_list.insert(route_list.end(), other.route_list.begin(), other.route_list.end());
+        this->mark_from(len);
         cost += other.cost;
     }
-    void reserve(Data &data)
+    void reserve(const Data &data)
     {
         this->route_list.reserve(data.vehicle.max_num);
     }
 
-    void append(Route &r)
+    void append(const Route &r)
+    {
+        this->route_list.push_back(std::make_shared<Route>(r));
+        this->mark_from(this->len() - 1);
+    }
+    // append route index of other, shared until one of the two solutions modifies it
+    void append(const Solution &other, int index)
     {
-        this->route_list.push_back(r);
+        this->route_list.push_back(other.route_list[index]);
+        this->mark_from(this->len() - 1);
     }
 
     void del(int index)
     {
         this->route_list.erase(this->route_list.begin() + index);
+        this->mark_from(index);
     }
 
     Route &get(int index)
     {
-        return this->route_list[index];
+        this->mark(index);
+        return this->detach(this->route_list[index]);
+    }
+    const Route &peek(int index) const
+    {
+        return *this->route_list[index];
     }
     Route &get_tail()
     { 
-        return *(route_list.end() - 1);
+        this->mark(this->len() - 1);
+        return this->detach(this->route_list.back());
     }
 
-    int len()
+    int len() const
     {
         return int(this->route_list.size());
     }
 
-    void update(Data &data)
+    void update(const Data &data)
     {
         // update all routes, and delete empty routes
         int len = this->len();
@@ -418,6 +563,19 @@ public:
         }
     }
 
+    // update the routes in route_indice (ascending) only, and delete those that became empty
+    void update(const Data &data, const std::vector<int> &route_indice)
+    {
+        for (int k = int(route_indice.size()) - 1; k >= 0; k--)
+        {
+            int index = route_indice[k];
+            Route &route = this->get(index);
+            route.update(data);
+            route.total_cost = route.cal_cost(data);
+            if (route.isempty()) this->del(index);
+        }
+    }
+
     void local_update(std::vector<int> &route_indice)
     {
         // delete empty routes in route_indice, and maintain route_list
@@ -430,7 +588,7 @@ public:
         {
             // there are at most 2 route index in the array
             // and at most 1 route is emppty
-            if (this->get(item).isempty())
+            if (this->peek(item).isempty())
                 empty_id = item;
             if (item == len - 1)
                 last_id_in = true;
@@ -440,45 +598,85 @@ public:
             if (empty_id == len - 1)
             {
                 this->route_list.pop_back();
+                this->mark_from(len - 1);
             }
             else
             {
                 this->route_list[empty_id] = *(this->route_list.end() - 1);
                 this->route_list.pop_back();
+                this->mark_from(len - 1);
+                this->mark(empty_id);
                 if (!last_id_in)
                     route_indice.push_back(len - 1);
             }
         }
     }
 
-    void clear(Data &data)
+    void clear(const Data &data)
     {
         // clear route_list
         this->route_list.clear();
         this->route_list.reserve(data.vehicle.max_num);
         this->cost = 0.0;
+        this->drop_index();
+    }
+
+    // route and position of customer c, false if no route serves c
+    bool locate(int c, const Data &data, int &route, int &pos)
+    {
+        this->index_customers(data);
+        if (this->indexed_at(c, route, pos)) return true;
+        if (this->where[c].first < 0) return false;
+        this->drop_index();
+        this->index_customers(data);
+        return this->indexed_at(c, route, pos);
+    }
+
+    // build the customer index, or re-index the routes modified since the last call
+    void index_customers(const Data &data)
+    {
+        int len = this->len();
+        if (this->where.empty())
+        {
+            this->where.assign(data.node_num, std::make_pair(-1, -1));
+            this->is_stale.assign(len, 1);
+            this->stale.resize(len);
+            for (int r = 0; r < len; r++) this->stale[r] = r;
+        }
+        for (int r : this->stale)
+        {
+            // a route may be listed again after it changed place
+            if (r >= len || !this->is_stale[r]) continue;
+            this->is_stale[r] = 0;
+            const std::vector<int> &nl = this->peek(r).node_list;
+            for (int pos = 0; pos < int(nl.size()); pos++)
+            {
+                if (data.node[nl[pos]].type == 1) this->where[nl[pos]] = std::make_pair(r, pos);
+            }
+        }
+        this->stale.clear();
     }
 
-    double cal_cost(Data &data)
+    double cal_cost(const Data &data)
     {
         this->cost = 0.0;
-        for (auto route = this->route_list.begin(); route < this->route_list.end(); route++)
+        for (auto &route : this->route_list)
         {
-            this->cost += route->cal_cost(data);
+            this->cost += this->detach(route).cal_cost(data);
         }
         return this->cost;
     }
 
-    std::string build_output_str(Data &data)
+    std::string build_output_str(const Data &data)
     {
         std::string output_s = "Details of the solution:\n";
         int len = this->len();
         for (int i = 0; i < len; i++)
         {
-            std::vector<int> &nl = this->route_list[i].node_list;
+            const std::vector<int> &nl = this->peek(i).node_list;
             output_s += "route " + std::to_string(i) +
                         ", node_num " + std::to_string(nl.size()) +
-                        ", cost " + std::to_string(this->route_list[i].transcost) +
+                        ", cost " + std::to_string(this->peek(i).transcost) +
                         ", nodes:";
             int pre = -1;            
             for (int node : nl)
@@ -505,7 +703,7 @@ public:
         return output_s;
     }
 
-    void output(Data &data)
+    void output(const Data &data)
     {
         std::string output_s = this->build_output_str(data);
         if (!data.if_output) std::cout << output_s;
@@ -516,7 +714,7 @@ public:
         }
     }
 
-    bool check(Data &data)
+    bool check(const Data &data)
     {
         double total_cost = 0.0;
         int len = this->len();
@@ -0,0 +1,181 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+/* uniform grid over the coordinates of a set of nodes (projected for lng/lat instances),
+about two nodes per cell. Answers k-nearest and radius queries without scanning all nodes */
+class SpatialGrid
+{
+public:
+    template <typename P>
+    void build(const std::vector<P> &node, const std::vector<int> &ids)
+    {
+        int n = int(ids.size());
+        this->ids.clear();
+        this->px.clear();
+        this->py.clear();
+        this->cell_start.clear();
+        if (n == 0) return;
+        double max_x = node[ids[0]].x, max_y = node[ids[0]].y;
+        this->min_x = max_x;
+        this->min_y = max_y;
+        for (int id : ids)
+        {
+            this->min_x = std::min(this->min_x, node[id].x);
+            this->min_y = std::min(this->min_y, node[id].y);
+            max_x = std::max(max_x, node[id].x);
+            max_y = std::max(max_y, node[id].y);
+        }
+        double w = max_x - this->min_x, h = max_y - this->min_y;
+        double area = std::max(w, 1e-9) * std::max(h, 1e-9);
+        this->cell = std::max(std::sqrt(2.0 * area / n), std::max(w, h) / n);
+        if (!(this->cell > 0.0)) this->cell = 1.0;
+        this->cols = int(w / this->cell) + 1;
+        this->rows = int(h / this->cell) + 1;
+
+        // counting sort of the nodes by cell
+        std::vector<int> cell_of(n);
+        this->cell_start.assign(this->cols * this->rows + 1, 0);
+        for (int t = 0; t < n; t++)
+        {
+            cell_of[t] = this->cell_y(node[ids[t]].y) * this->cols + this->cell_x(node[ids[t]].x);
+            this->cell_start[cell_of[t] + 1]++;
+        }
+        for (size_t c = 1; c < this->cell_start.size(); c++) this->cell_start[c] += this->cell_start[c - 1];
+        std::vector<int> fill(this->cell_start.begin(), this->cell_start.end() - 1);
+        this->ids.resize(n);
+        this->px.resize(n);
+        this->py.resize(n);
+        for (int t = 0; t < n; t++)
+        {
+            int pos = fill[cell_of[t]]++;
+            this->ids[pos] = ids[t];
+            this->px[pos] = node[ids[t]].x;
+            this->py[pos] = node[ids[t]].y;
+        }
+    }
+
+    int size() const { return int(this->ids.size()); }
+
+    // the k nodes nearest to (x, y), nearest first
+    void nearest(double x, double y, int k, std::vector<int> &out) const
+    {
+        out.clear();
+        k = std::min(k, this->size());
+        if (k <= 0) return;
+        std::vector<std::pair<double, int>> cand;
+        int cx = this->cell_x(x), cy = this->cell_y(y);
+        for (int r = 0; ; r++)
+        {
+            for (int gy = cy - r; gy <= cy + r; gy++)
+            {
+                if (gy < 0 || gy >= this->rows) continue;
+                bool edge = (gy == cy - r || gy == cy + r);
+                for (int gx = cx - r; gx <= cx + r; gx += (edge ? 1 : 2 * r))
+                {
+                    if (gx >= 0 && gx < this->cols) this->collect(gy * this->cols + gx, x, y, cand);
+                    if (r == 0) break;
+                }
+            }
+            // nodes not visited yet are in cells outside the block of rings 0..r
+            double bound = double(INFINITY);
+            if (cx - r > 0) bound = std::min(bound, x - (this->min_x + (cx - r) * this->cell));
+            if (cx + r < this->cols - 1) bound = std::min(bound, this->min_x + (cx + r + 1) * this->cell - x);
+            if (cy - r > 0) bound = std::min(bound, y - (this->min_y + (cy - r) * this->cell));
+            if (cy + r < this->rows - 1) bound = std::min(bound, this->min_y + (cy + r + 1) * this->cell - y);
+            if (int(cand.size()) >= k)
+            {
+                std::nth_element(cand.begin(), cand.begin() + k - 1, cand.end());
+                if (cand[k - 1].first <= bound * bound) break;
+            }
+            if (bound == double(INFINITY)) break;
+        }
+        std::partial_sort(cand.begin(), cand.begin() + k, cand.end());
+        for (int t = 0; t < k; t++) out.push_back(cand[t].second);
+    }
+
+    // all nodes within radius of (x, y)
+    void within(double x, double y, double radius, std::vector<int> &out) const
+    {
+        out.clear();
+        if (this->size() == 0) return;
+        double r2 = radius * radius;
+        int x0 = this->cell_x(x - radius), x1 = this->cell_x(x + radius);
+        int y0 = this->cell_y(y - radius), y1 = this->cell_y(y + radius);
+        for (int gy = y0; gy <= y1; gy++)
+        {
+            for (int gx = x0; gx <= x1; gx++)
+            {
+                int c = gy * this->cols + gx;
+                for (int t = this->cell_start[c]; t < this->cell_start[c + 1]; t++)
+                {
+                    double dx = this->px[t] - x, dy = this->py[t] - y;
+                    if (dx * dx + dy * dy <= r2) out.push_back(this->ids[t]);
+                }
+            }
+        }
+    }
+
+    /* the n nodes of the smallest cost(id), ordered by (cost, id). The search is restricted to the
+    nodes near (x, y), which requires cost(id) >= lb * (distance of id to (x, y) - slack) for lb > 0;
+    with lb = 0 all nodes are ranked */
+    template <typename Cost>
+    void smallest(double x, double y, double lb, double slack, int n, Cost cost, std::vector<int> &out) const
+    {
+        out.clear();
+        n = std::min(n, this->size());
+        if (n <= 0) return;
+        std::vector<std::pair<double, int>> c;
+        std::vector<int> cand;
+        double bound = double(INFINITY);
+        if (lb > 0.0)
+        {
+            // the n-th smallest cost among the nearest nodes bounds the radius to search
+            for (int m = n; ; m = std::min(2 * m, this->size()))
+            {
+                this->nearest(x, y, m, cand);
+                c.clear();
+                for (int id : cand)
+                {
+                    double v = cost(id);
+                    if (v < double(INFINITY)) c.push_back(std::make_pair(v, id));
+                }
+                if (int(c.size()) >= n || m == this->size()) break;
+            }
+            if (int(c.size()) >= n)
+            {
+                std::nth_element(c.begin(), c.begin() + n - 1, c.end());
+                bound = c[n - 1].first;
+            }
+        }
+        if (bound < double(INFINITY))
+            this->within(x, y, (bound / lb + slack) * (1.0 + 1e-9), cand);
+        else
+            cand = this->ids;
+        c.clear();
+        for (int id : cand) c.push_back(std::make_pair(cost(id), id));
+        std::partial_sort(c.begin(), c.begin() + n, c.end());
+        for (int t = 0; t < n; t++) out.push_back(c[t].second);
+    }
+
+private:
+    double min_x = 0.0, min_y = 0.0, cell = 1.0;
+    int cols = 0, rows = 0;
+    std::vector<int> cell_start; // nodes of cell c are at [cell_start[c], cell_start[c+1])
+    std::vector<int> ids;
+    std::vector<double> px, py;
+
+    int cell_x(double x) const { return int(std::min(std::max(std::floor((x - this->min_x) / this->cell), 0.0), double(this->cols - 1))); }
+    int cell_y(double y) const { return int(std::min(std::max(std::floor((y - this->min_y) / this->cell), 0.0), double(this->rows - 1))); }
+
+    void collect(int c, double x, double y, std::vector<std::pair<double, int>> &cand) const
+    {
+        for (int t = this->cell_start[c]; t < this->cell_start[c + 1]; t++)
+        {
+            double dx = this->px[t] - x, dy = this->py[t] - y;
+            cand.push_back(std::make_pair(dx * dx + dy * dy, this->ids[t]));
+        }
+    }
+};
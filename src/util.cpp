@@ -1,4 +1,7 @@
 #include "util.h"
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 
 // split string with a delimiter
 std::vector<std::string> split(const std::string &s, char delimiter)
@@ -11,4 +14,103 @@ std::vector<std::string> split(const std::string &s, char delimiter)
         tokens.push_back(token);
     }
     return tokens;
+}
+
+namespace
+{
+// one parallel_for call over workers [0, lanes). The caller runs lane 0, pool threads claim the
+// other lanes, and the lanes no pool thread claimed before the caller got to them are run by the caller
+struct Job
+{
+    int n, lanes;
+    bool fixed;
+    const std::function<void(int, int)> &task;
+    std::atomic<int> next;
+    int claimed = 1; // lanes taken so far
+    int running = 0; // lanes being run by pool threads
+    std::condition_variable done;
+
+    Job(int n, int lanes, bool fixed, const std::function<void(int, int)> &task)
+        : n(n), lanes(lanes), fixed(fixed), task(task), next(0) {}
+
+    void run(int lane)
+    {
+        if (this->fixed)
+            for (int i = lane; i < this->n; i += this->lanes) this->task(i, lane);
+        else
+            for (int i = this->next++; i < this->n; i = this->next++) this->task(i, lane);
+    }
+};
+
+/* threads kept for the whole process, such that a parallel region does not create and join threads
+every time. A pool thread takes the next lane of the oldest job with lanes left. Lanes may start
+nested jobs, threads are added whenever fewer are idle than lanes are waiting for one */
+class ThreadPool
+{
+public:
+    void run(Job &job)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->jobs.push_back(&job);
+        this->waiting += job.lanes - 1;
+        for (; this->idle < this->waiting; this->idle++) std::thread(&ThreadPool::serve, this).detach();
+        for (int lane = 1; lane < job.lanes; lane++) this->ready.notify_one();
+        lock.unlock();
+
+        job.run(0);
+
+        lock.lock();
+        int first = job.claimed;
+        if (first < job.lanes)
+        {
+            this->jobs.erase(std::find(this->jobs.begin(), this->jobs.end(), &job));
+            this->waiting -= job.lanes - first;
+            job.claimed = job.lanes;
+        }
+        lock.unlock();
+        for (int lane = first; lane < job.lanes; lane++) job.run(lane);
+        lock.lock();
+        job.done.wait(lock, [&job]() { return job.running == 0; });
+    }
+
+private:
+    std::mutex mutex; // guards all below and claimed, running of the jobs
+    std::condition_variable ready;
+    std::deque<Job *> jobs; // with lanes not claimed yet
+    int waiting = 0; // lanes not claimed yet
+    int idle = 0; // threads waiting for a lane
+
+    void serve()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (true)
+        {
+            this->ready.wait(lock, [this]() { return !this->jobs.empty(); });
+            Job &job = *this->jobs.front();
+            int lane = job.claimed++;
+            if (job.claimed == job.lanes) this->jobs.pop_front();
+            this->waiting--;
+            this->idle--;
+            job.running++;
+            lock.unlock();
+            job.run(lane);
+            lock.lock();
+            this->idle++;
+            if (--job.running == 0) job.done.notify_all();
+        }
+    }
+};
+}
+
+void parallel_for(int n, int threads, const std::function<void(int, int)> &task, bool fixed)
+{
+    if (threads <= 1 || n <= 1)
+    {
+        for (int i = 0; i < n; i++) task(i, 0);
+        return;
+    }
+    // never destroyed: its threads may still wait for work when the process exits
+    static ThreadPool *pool = new ThreadPool();
+    Job job(n, std::min(threads, n), fixed, task);
+    pool->run(job);
 }
\ No newline at end of file
@@ -6,6 +6,14 @@
 #include <cctype>
 #include <locale>
 #include <random>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <ctime>
+#include <new>
+#include <climits>
+#include "config.h"
 
 // split string with a delimiter
 std::vector<std::string> split(const std::string &s, char delimiter);
@@ -105,3 +113,89 @@ static inline double rand(double from, double end, std::mt19937 &rng)
     return distr(rng);
 }
 
+// wall-clock time in clock() units. Unlike clock(), it does not add up the cpu time of all threads
+static inline clock_t wall_clock()
+{
+    auto now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch());
+    return clock_t(now.count() * (CLOCKS_PER_SEC / 1e6));
+}
+
+// run task(i, worker) for every i in [0, n) on `threads` threads, worker is in [0, threads). The
+// calling thread is worker 0, the others come from a pool of threads kept for the whole process.
+// Tasks are handed out dynamically, so task must not depend on which worker runs it. With fixed,
+// task i runs on worker i % threads, such that what a worker keeps between its tasks does not
+// depend on the thread timing
+void parallel_for(int n, int threads, const std::function<void(int, int)> &task, bool fixed = false);
+
+// allocator recycling buffers through free lists per size class (powers of two). Every thread has
+// its own lists, which live as long as the thread: the search thread and the pool threads of
+// parallel_for. A buffer freed on another thread than the one allocating it joins the lists of
+// the freeing thread. At most POOL_MAX_BYTES of free buffers are kept per thread
+template <typename T>
+class PoolAllocator
+{
+public:
+    typedef T value_type;
+
+    PoolAllocator() {}
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &) {}
+
+    T *allocate(size_t n)
+    {
+        int c = size_class(n);
+        FreeLists &lists = free_lists();
+        if (!lists.list[c].empty())
+        {
+            void *p = lists.list[c].back();
+            lists.list[c].pop_back();
+            lists.bytes -= sizeof(T) << c;
+            return static_cast<T *>(p);
+        }
+        return static_cast<T *>(::operator new(sizeof(T) << c));
+    }
+
+    void deallocate(T *p, size_t n)
+    {
+        int c = size_class(n);
+        FreeLists &lists = free_lists();
+        if (lists.bytes + (sizeof(T) << c) > POOL_MAX_BYTES)
+        {
+            ::operator delete(p);
+            return;
+        }
+        lists.list[c].push_back(p);
+        lists.bytes += sizeof(T) << c;
+    }
+
+private:
+    struct FreeLists
+    {
+        std::vector<void *> list[sizeof(size_t) * CHAR_BIT];
+        size_t bytes = 0;
+        ~FreeLists()
+        {
+            for (auto &l : list)
+                for (void *p : l) ::operator delete(p);
+        }
+    };
+
+    static FreeLists &free_lists()
+    {
+        static thread_local FreeLists lists;
+        return lists;
+    }
+
+    // smallest c with n <= 2^c
+    static int size_class(size_t n)
+    {
+        int c = 0;
+        while ((size_t(1) << c) < n) c++;
+        return c;
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T> &, const PoolAllocator<U> &) { return true; }
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T> &, const PoolAllocator<U> &) { return false; }